@@ -11,9 +11,19 @@
 #include "GaudiKernel/IInterface.h"
 #include "enums/GemState.h"
 
+#include <cstddef>
+
 
 // Declaration of the interface ID ( interface id, major version, minor version) 
-static const InterfaceID IID_ILivetimeSvc("ILivetimeSvc", 1, 0); 
+static const InterfaceID IID_ILivetimeSvc("ILivetimeSvc", 1, 2); 
+
+/// GEM clock counts for an event, each converted once from the time in seconds
+struct LivetimeTicks {
+    unsigned long long time;      ///< ticks(current_time)
+    unsigned long long onePps;    ///< ticks at the last whole second
+    unsigned long long livetime;  ///< ticks(livetime())
+    unsigned long long elapsed;   ///< ticks(elapsed())
+};
 
 /** 
 * \class ILivetimeSvc
@@ -49,6 +59,19 @@ public:
 
     /// get number of GEM clock ticks
     virtual unsigned long long ticks(double time) const=0;
+
+    /// the clock counts of an event, for the GEM and its scalers
+    virtual void tickSnapshot(double current_time, LivetimeTicks& snapshot) const=0;
+
+    /// for events in time order, what checkState, isLive and, if live, tryToRegisterEvent do
+    /// for each in turn, in one call
+    /// @param times event times
+    /// @param longdeadtime four-range readout for each event
+    /// @param states the state of each, before it is registered
+    /// @param live whether each was live, and so registered
+    /// @param livetimes the accumulated livetime after each
+    virtual void registerEvents(const double* times, const bool* longdeadtime, size_t count,
+                                enums::GemState* states, bool* live, double* livetimes)=0;
 };
 
 #endif  // _H_ILivetimeSvc
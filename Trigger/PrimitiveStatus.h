@@ -0,0 +1,53 @@
+/**
+ * @file PrimitiveStatus.h
+ * @brief header for class PrimitiveStatus
+
+ $Header:  $
+*/
+
+#ifndef PRIMITIVESTATUS_H
+#define PRIMITIVESTATUS_H
+
+#include "GaudiKernel/DataObject.h"
+
+/**
+* @class PrimitiveStatus
+* @brief TDS record of which trigger primitives of the TriggerInfo were computed
+*
+* Registered by TriggerInfoAlg when its lazyPrimitives option is set: a primitive that
+* could not change the engine selected for the event is skipped, and its vector in the
+* TriggerInfo, and its bits in the trigger word, are then zero without having been computed.
+* TriggerAlg computes skipped primitives that its own configuration needs, and adds them here.
+* If there is no PrimitiveStatus in the TDS, all primitives were computed.
+*/
+
+namespace Trigger{
+      class PrimitiveStatus : public DataObject{
+
+      public:
+
+	//! the primitives
+	enum { TKR = 1, ACD = 2, ROI = 4, CAL = 8, ALL = TKR|ACD|ROI|CAL };
+
+	PrimitiveStatus(unsigned int computed=ALL) : m_computed(computed) {}
+      	virtual ~PrimitiveStatus(){}
+
+	//! TDS location
+	static const char* path(){ return "/Event/TriggerPrimitiveStatus"; }
+
+	//! mask of the primitives that were computed
+	unsigned int computed() const { return m_computed; }
+
+	//! true if the given primitive was computed
+	bool computed(unsigned int primitive) const { return (m_computed & primitive)==primitive; }
+
+	//! record primitives computed later, by TriggerAlg
+	void addComputed(unsigned int primitives) { m_computed |= primitives; }
+
+      private:
+
+      	unsigned int m_computed;
+      };
+}// namespace Trigger
+
+#endif
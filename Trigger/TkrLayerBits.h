@@ -0,0 +1,116 @@
+/**
+ * @file TkrLayerBits.h
+ * @brief header for class TkrLayerBits
+
+ $Header:  $
+*/
+
+#ifndef TKRLAYERBITS_H
+#define TKRLAYERBITS_H
+
+#include "GaudiKernel/DataObject.h"
+#include "GaudiKernel/IDataProviderSvc.h"
+#include "GaudiKernel/SmartDataPtr.h"
+#include "GaudiKernel/StatusCode.h"
+
+#include "Event/TopLevel/EventModel.h"
+#include "Event/Digi/TkrDigi.h"
+
+#include "Trigger/TriRowBits.h"
+
+/**
+* @class TkrLayerBits
+* @brief TDS for the hit tracker layers of each tower and view, and the 3-in-a-row words derived from them
+*
+* Made once per event from the TkrDigiCol, by whichever of TriggerInfoAlg and TriRowBitsAlg runs first,
+* and then shared by the other: see get().
+*/
+
+namespace TriRowBitsTds{
+      class TkrLayerBits : public DataObject{
+
+      public:
+
+        TkrLayerBits();
+      	virtual ~TkrLayerBits(){}
+
+	//! TDS location
+	static const char* path(){ return "/Event/TkrLayerBits"; }
+
+	//! the object for the current event: from the TDS, or made from the TkrDigiCol and registered. 0 if no digis
+	static TkrLayerBits* get(IDataProviderSvc* eventSvc);
+	//! the same, adding the number of lookups in the data service to lookups
+	static TkrLayerBits* get(IDataProviderSvc* eventSvc, unsigned int& lookups);
+
+	//! bit i is set if layers i, i+1 and i+2 are all hit: the 16 combinations of 18 layers
+	static unsigned int three_in_a_row(unsigned int bits){ return bits & bits>>1 & bits>>2 & 0xffff; }
+
+	//! set the layer bits from the digis, and compute the 3-in-a-row words
+	void fill(const Event::TkrDigiCol& digis);
+
+	//! hit layers (18 bits) of a tower, view 0 for x and 1 for y
+      	unsigned int getLayerBits(const int tower, const int view) const { return m_layerBits[tower][view]; }
+
+	//! 3 in a row combinations of x-y coincidences for a tower (see TriRowBits.h)
+      	unsigned int getTriRowBits(const int tower) const { return m_triRowBits[tower]; }
+
+	//! one bit for each tower with any 3 in a row
+      	unsigned short getTkrVector() const { return m_tkrVector; }
+
+      private:
+
+      	unsigned int   m_layerBits[NUM_TWRS][2];
+      	unsigned int   m_triRowBits[NUM_TWRS];
+      	unsigned short m_tkrVector;
+      };
+
+      //! Initialize arrays
+      inline TkrLayerBits::TkrLayerBits() : m_tkrVector(0) {
+          for(unsigned i=0; i<NUM_TWRS; i++)
+	    {
+	      m_layerBits[i][0]=m_layerBits[i][1]=0;
+	      m_triRowBits[i]=0;
+	    }
+      }
+
+      inline void TkrLayerBits::fill(const Event::TkrDigiCol& digis){
+          for( Event::TkrDigiCol::const_iterator it = digis.begin(); it != digis.end(); ++it){
+              const Event::TkrDigi& t = **it;
+              if( t.getNumHits()== 0) continue; // this can happen if there are dead strips
+              unsigned int tower = t.getTower().id();
+              if( tower>=NUM_TWRS ) continue;
+              m_layerBits[tower][t.getView()==idents::GlastAxis::X ? 0 : 1] |= 1 << t.getBilayer();
+          }
+          m_tkrVector = 0;
+          for(unsigned tower=0; tower<NUM_TWRS; tower++)
+	    {
+	      m_triRowBits[tower] = three_in_a_row(m_layerBits[tower][0] & m_layerBits[tower][1]);
+	      m_tkrVector |= (m_triRowBits[tower]!=0) << tower;
+	    }
+      }
+
+      inline TkrLayerBits* TkrLayerBits::get(IDataProviderSvc* eventSvc){
+          unsigned int lookups(0);
+          return get(eventSvc, lookups);
+      }
+
+      inline TkrLayerBits* TkrLayerBits::get(IDataProviderSvc* eventSvc, unsigned int& lookups){
+          ++lookups;
+          SmartDataPtr<TkrLayerBits> found(eventSvc, path());
+          if( found!=0 ) return found;
+
+          ++lookups;
+          SmartDataPtr<Event::TkrDigiCol> planes(eventSvc, EventModel::Digi::TkrDigiCol);
+          if( planes==0 ) return 0;
+
+          TkrLayerBits* bits = new TkrLayerBits;
+          bits->fill(*planes);
+          if( eventSvc->registerObject(path(), bits).isFailure() ){
+              delete bits;
+              return 0;
+          }
+          return bits;
+      }
+}// namespace TriRowBitsTds
+
+#endif
@@ -0,0 +1,126 @@
+/**
+*  @file AcdTileTable.cxx
+*  @brief Implementation of the class AcdTileTable
+*
+*  $Header:  $
+*/
+
+#include "AcdTileTable.h"
+#include "TileListBits.h"
+
+#include "Event/Digi/AcdDigi.h"
+
+#include "idents/AcdId.h"
+
+#include "ConfigSvc/IConfigSvc.h"
+
+using namespace Trigger;
+
+namespace {
+    /// ACD ids are face*100+row*10+column for faces 0-6; the NA tiles follow 1000
+    const unsigned int ACD_TILE_IDS = 1100;
+}
+
+//------------------------------------------------------------------------------
+AcdTileTable::AcdTileTable()
+{
+    TrgRoi roi;
+    setDefaultRoi(roi);
+    fill(roi);
+}
+
+AcdTileTable::AcdTileTable(const TrgRoi& roi)
+{
+    fill(roi);
+}
+
+//------------------------------------------------------------------------------
+void AcdTileTable::Tile::set(unsigned int id)
+{
+    unsigned int garc, gafe;
+    garc=gafe=0xff;
+    idents::AcdId::convertToGarcGafe(id, Event::AcdDigi::A, garc, gafe);
+    garcBitA = garc<16 ? 1<<garc : 0;
+    garc=gafe=0xff;
+    idents::AcdId::convertToGarcGafe(id, Event::AcdDigi::B, garc, gafe);
+    garcBitB = garc<16 ? 1<<garc : 0;
+
+    gemIndex = idents::AcdId::gemIndexFromTile(id);
+    gemValid = TileListBits::valid(gemIndex);
+    roiMask  = 0;
+    known = true;
+}
+
+//------------------------------------------------------------------------------
+void AcdTileTable::fill(const TrgRoi& constRoi)
+{
+    // the ROI is only read, here and nowhere else
+    TrgRoi& roi = const_cast<TrgRoi&>(constRoi);
+
+    m_tiles.assign(ACD_TILE_IDS, Tile());
+
+    for (unsigned int id = 0; id < ACD_TILE_IDS; id++)
+    {
+        unsigned int row = id/10 % 10, column = id % 10;
+        if ( id < 1000 && (id >= 700 || row > 4 || column > 4) ) continue; // not a tile id
+
+        Tile& tile = m_tiles[id];
+        tile.set(id);
+
+        std::vector<unsigned long> rr=roi.roiFromName(id);
+        for (unsigned int j=0;j<rr.size();j++){
+            tile.roiMask |= 1<<rr[j];
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+const AcdTileTable::Tile& AcdTileTable::tile(unsigned int id, Tile& scratch) const
+{
+    if (id < ACD_TILE_IDS && m_tiles[id].known) return m_tiles[id];
+
+    scratch.set(id);
+    return scratch;
+}
+
+//------------------------------------------------------------------------------
+void AcdTileTable::setDefaultRoi(TrgRoi& roi)
+{
+    roi.setRoiRegister(  0 , 0x30001 );
+    roi.setRoiRegister(  1 , 0xc0006 );
+    roi.setRoiRegister(  2 , 0x110008 );
+    roi.setRoiRegister(  3 , 0x660033 );
+    roi.setRoiRegister(  4 , 0x8800cc );
+    roi.setRoiRegister(  5 , 0x3300110 );
+    roi.setRoiRegister(  6 , 0xcc00660 );
+    roi.setRoiRegister(  7 , 0x11000880 );
+    roi.setRoiRegister(  8 , 0x66003300 );
+    roi.setRoiRegister(  9 , 0x8800cc00 );
+    roi.setRoiRegister( 10 , 0x30001000 );
+    roi.setRoiRegister( 11 , 0xc0006000 );
+    roi.setRoiRegister( 12 , 0x8000 );
+    roi.setRoiRegister( 13 , 0x10000 );
+    roi.setRoiRegister( 14 , 0x1100011 );
+    roi.setRoiRegister( 15 , 0x10001100 );
+    roi.setRoiRegister( 16 , 0x110001 );
+    roi.setRoiRegister( 17 , 0x11000110 );
+    roi.setRoiRegister( 18 , 0x1000 );
+    roi.setRoiRegister( 22 , 0x10000 );
+    roi.setRoiRegister( 23 , 0x60003 );
+    roi.setRoiRegister( 24 , 0x8000c );
+    roi.setRoiRegister( 25 , 0x30001 );
+    roi.setRoiRegister( 26 , 0xc0006 );
+    roi.setRoiRegister( 27 , 0x8 );
+    roi.setRoiRegister( 31 , 0x80000 );
+    roi.setRoiRegister( 32 , 0x8800088 );
+    roi.setRoiRegister( 33 , 0x80008800 );
+    roi.setRoiRegister( 34 , 0x880008 );
+    roi.setRoiRegister( 35 , 0x88000880 );
+    roi.setRoiRegister( 36 , 0x8000 );
+    roi.setRoiRegister( 40 , 0x10000000 );
+    roi.setRoiRegister( 41 , 0x60003000 );
+    roi.setRoiRegister( 42 , 0x8000c000 );
+    roi.setRoiRegister( 43 , 0x30001000 );
+    roi.setRoiRegister( 44 , 0xc0006000 );
+    roi.setRoiRegister( 45 , 0x8000 );
+}
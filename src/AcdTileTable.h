@@ -0,0 +1,59 @@
+/** @file AcdTileTable.h
+  *  @brief Declaration of the class AcdTileTable
+  *
+  *  $Header:  $
+*/
+
+#ifndef Trigger_AcdTileTable_h
+#define Trigger_AcdTileTable_h
+
+#include <vector>
+
+class TrgRoi;
+
+namespace Trigger {
+
+/** @class AcdTileTable
+    @brief what the trigger needs to know about each ACD tile, for one ROI configuration
+
+    The GARC bits, GEM tile list index and ROI tower mask of every tile id, made from
+    idents::AcdId and a TrgRoi when the configuration is first used. The table does not keep
+    the TrgRoi, and is not changed once made, so that it can be shared by the events of
+    that configuration.
+*/
+class AcdTileTable {
+public:
+    struct Tile
+    {
+        unsigned short garcBitA;  ///< cno vector bit for PMT A, 0 if none
+        unsigned short garcBitB;  ///< cno vector bit for PMT B, 0 if none
+        unsigned int   gemIndex;  ///< index in the GEM tile list
+        bool           gemValid;  ///< the gem index is in one of the tile list words
+        unsigned short roiMask;   ///< towers in the ROI of the tile
+        bool           known;     ///< set() was called
+
+        /// all but the ROI mask, which is cleared
+        void set(unsigned int id);
+    };
+
+    /// the tiles, with the ROI of the default configuration
+    AcdTileTable();
+
+    /// the tiles, with the ROI of a ConfigSvc configuration
+    explicit AcdTileTable(const TrgRoi& roi);
+
+    /// the table entry for a tile id, or if not in the table, scratch filled for it without ROI
+    const Tile& tile(unsigned int id, Tile& scratch)const;
+
+    /// the ROI registers of the default configuration
+    static void setDefaultRoi(TrgRoi& roi);
+
+private:
+    /// fill the table, with the ROI tower masks of roi
+    void fill(const TrgRoi& roi);
+
+    std::vector<Tile> m_tiles;  ///< indexed by tile id
+};
+
+}
+#endif
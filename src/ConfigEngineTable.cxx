@@ -0,0 +1,47 @@
+/**
+*  @file ConfigEngineTable.cxx
+*  @brief Implementation of the class ConfigEngineTable
+*
+*  $Header:  $
+*/
+
+#include "ConfigEngineTable.h"
+
+#include "configData/gem/TrgConfig.h"
+
+using namespace Trigger;
+
+ConfigEngineTable::ConfigEngineTable()
+: m_config(0)
+, m_engines(0)
+{
+    Entry none = { -1, -1, true, false };
+    for( int t=0; t<tableSize; ++t) m_entry[t] = none;
+}
+
+void ConfigEngineTable::set(const TrgConfig* tcf)
+{
+    m_config  = tcf;
+    m_engines = 0;
+    for( int t=0; t<tableSize; ++t){
+        Entry& entry = m_entry[t];
+        entry.engine = tcf->lut()->engineNumber(t);
+        if( entry.engine<0 ){
+            entry.prescale  = -1;
+            entry.inhibited = true;
+            entry.fourRange = false;
+            continue;
+        }
+        entry.prescale  = tcf->trgEngine()->prescale(entry.engine);
+        entry.inhibited = tcf->trgEngine()->inhibited(entry.engine);
+        entry.fourRange = tcf->trgEngine()->fourRangeReadout(entry.engine);
+        if( entry.engine>=m_engines ) m_engines = entry.engine+1;
+    }
+}
+
+void ConfigEngineTable::set(unsigned int condsummary, const Entry& entry)
+{
+    m_config = 0;
+    m_entry[condsummary&(tableSize-1)] = entry;
+    if( entry.engine>=m_engines ) m_engines = entry.engine+1;
+}
@@ -0,0 +1,57 @@
+/** @file ConfigEngineTable.h
+  *  @brief Declaration of the class ConfigEngineTable
+  *
+  *  $Header:  $
+*/
+
+#ifndef Trigger_ConfigEngineTable_h
+#define Trigger_ConfigEngineTable_h
+
+class TrgConfig;
+
+namespace Trigger {
+
+/** @class ConfigEngineTable
+    @brief flattened engine lookup for a ConfigSvc trigger configuration
+
+    For each GEM condition summary, the engine selected by the TrgConfig lookup table,
+    with the prescale, inhibit and four-range readout flags of that engine.
+    It is filled once when the configuration changes, so that the per event
+    lookups are array loads rather than calls into the TrgConfig.
+*/
+class ConfigEngineTable {
+public:
+    enum { tableSize = 256 }; ///< full width of the GEM condition summary
+
+    struct Entry {
+        int  engine;     ///< engine number, -1 if the configuration has none
+        int  prescale;   ///< prescale factor of the engine
+        bool inhibited;  ///< engine is inhibited
+        bool fourRange;  ///< engine requests four-range readout (long deadtime)
+    };
+
+    ConfigEngineTable();
+
+    /// fill the table from a trigger configuration
+    void set(const TrgConfig* tcf);
+
+    /// set the entry of one condition summary, for a table not made from a TrgConfig
+    void set(unsigned int condsummary, const Entry& entry);
+
+    /// true if the table was filled from this configuration
+    bool filledFrom(const TrgConfig* tcf)const{ return tcf!=0 && tcf==m_config; }
+
+    /// entry for a condition summary
+    const Entry& operator[](unsigned int condsummary)const{ return m_entry[condsummary&(tableSize-1)]; }
+
+    /// one more than the largest engine number in the table
+    int engines()const{ return m_engines; }
+
+private:
+    Entry            m_entry[tableSize];
+    const TrgConfig* m_config;  ///< configuration used to fill the table
+    int              m_engines;
+};
+
+}
+#endif
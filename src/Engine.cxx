@@ -12,33 +12,42 @@
 using namespace Trigger;
 
 Engine::Engine( std::vector<Engine::BitStatus>condition , int marker, int prescale )
-: m_condition(condition)
+: m_mask(0)
+, m_value(0)
 , m_marker(marker)
 , m_prescale(prescale)
 , m_4range(false)
-, m_scalar(0)
-{}
+, m_ordinal(0)
+{
+    // only the first 8 entries are significant, as before
+    for( unsigned int i=0; i< condition.size() && i<8; ++i){
+        setBit(i, condition[i]);
+    }
+}
 
 Engine::Engine( std::string condition_summary ,  int marker, int prescale)
-: m_marker(marker)
+: m_mask(0)
+, m_value(0)
+, m_marker(marker)
 , m_prescale(prescale)
 , m_4range(false)
-, m_scalar(0)
+, m_ordinal(0)
 {
     int k(7);
-    m_condition.resize(8);
     for( unsigned int i=0; i< condition_summary.size(); ++i){
         char c=condition_summary[i];
+        if( c!=' ' && k<0 ) { k=-2; break;} // too many: report below
         switch (c){
             case ' ': break;
             case '1':
-            case 'Y': m_condition[k--] = Engine::Y; break;
+            case 'Y': setBit(k--, Engine::Y); break;
             case '0':
-            case 'N': m_condition[k--] = Engine::N; break;
+            case 'N': setBit(k--, Engine::N); break;
             case 'x':
-            case 'X': m_condition[k--] = Engine::X; break;
+            case 'X': setBit(k--, Engine::X); break;
             default:
-                std::string err("Engine parse error, unrecognized character "+c);
+                std::string err("Engine parse error, unrecognized character ");
+                err += c;
                 std::cerr << err << std::endl;
                 throw std::invalid_argument(err);
         }
@@ -52,41 +61,48 @@ Engine::Engine( std::string condition_summary ,  int marker, int prescale)
 
 }
 
-void Engine::print(std::ostream& out)const
+Engine::Engine( unsigned int mask, unsigned int value, int marker, int prescale)
+: m_mask(mask&255)
+, m_value(value&mask&255)
+, m_marker(marker)
+, m_prescale(prescale)
+, m_4range(false)
+, m_ordinal(0)
+{}
+
+void Engine::setBit(int bit, BitStatus status)
 {
-    char code[]={'0', '1', 'x'};
-    out << "\t";
-    for(std::vector<BitStatus>::const_reverse_iterator it= m_condition.rbegin(); it!=m_condition.rend(); ++it){
-        out << code[*it] << "      ";
-    }
-    out << std::right << std::setw(4) << m_prescale << "   " << m_marker << std::endl;
+    unsigned int b(1u<<bit);
+    if( status==Engine::X ) return; // don't care: leave out of the mask
+    m_mask |= b;
+    if( status==Engine::Y ) m_value |= b;
 }
 
-
-bool Engine::match(int gltword) const
+void Engine::print(std::ostream& out)const
 {
-    int i(0);
-    for( ; i<8; ++i){
-        int c(m_condition[i]);
-        if( c== Engine::X ||  (gltword&1) == c ){
-            gltword /=2 ; continue;
-        }
-        return false; // fail to match
+    out << "\t";
+    for( int i=7; i>=0; --i){
+        unsigned int b(1u<<i);
+        out << ( (m_mask&b)==0? 'x' : (m_value&b)!=0 ? '1' : '0') << "      ";
     }
-    return true;
+    out << std::right << std::setw(4) << m_prescale << "   " << m_marker << std::endl;
 }
 
 int Engine::check()const
 {
     // here for a match: return marker if trigger ok.
+    return check(m_ordinal++);
+}
 
+int Engine::check(unsigned long long ordinal)const
+{
+    // every prescale+1 events, the last one passes: same as counting down from prescale
     if( m_prescale==0 ) return m_marker;
-    if( m_prescale<0 || m_scalar++ < m_prescale) return -1; 
-    m_scalar=0;
+    if( m_prescale<0 || ordinal % (m_prescale+1) != (unsigned long long)m_prescale ) return -1; 
     return m_marker;
 }
 
 void Engine::reset() 
 {  
-    m_scalar=0;
+    m_ordinal=0;
 }
@@ -31,9 +31,16 @@ public:
     typedef enum { N=0, Y=1, X=2 } BitStatus; ///< for No, Yes, maybe
     Engine( std::vector<BitStatus>condition ,int marker, int prescale=0);
     Engine( std::string condition_string ,int marker, int prescale=0);
+    /// Initialize from an already compiled condition: bits in mask must equal those in value
+    Engine( unsigned int mask, unsigned int value, int marker, int prescale=0);
 
     /// test the pattern: true if it matches the condition for this Engine
-    bool match(int gltword) const;
+    bool match(int gltword) const{ return (gltword & m_mask) == m_value; }
+
+    /// bits that are not "x" in the condition
+    unsigned int mask()const{return m_mask;}
+    /// required values of the bits selected by mask()
+    unsigned int value()const{return m_value;}
 
     void reset();
 
@@ -48,13 +55,27 @@ public:
     /// return marker if pass prescale: -1 otherwise
     int check()const;
 
+    /// return marker if the event with the given ordinal (count of previous events
+    /// for this engine) passes the prescale: -1 otherwise. Does not change the state.
+    int check(unsigned long long ordinal)const;
+
+    /// set the ordinal of the next event for check()
+    void seek(unsigned long long ordinal){ m_ordinal=ordinal; }
+
+    /// ordinal of the next event for check()
+    unsigned long long ordinal()const{ return m_ordinal; }
+
 private:
 
-    std::vector<BitStatus>m_condition;
+    /// set the condition for bit number bit
+    void setBit(int bit, BitStatus status);
+
+    unsigned int m_mask;   ///< condition bits that must match (the "care" mask)
+    unsigned int m_value;  ///< required values of the bits in m_mask
     int m_marker;    ///< code to return?
     int m_prescale;  ///< how much to prescale (<0 if disabled)
     bool m_4range;   ///< flag for CAL readout (not used here)
-    mutable int m_scalar;  ///< keeps a count for prescale
+    mutable unsigned long long m_ordinal;  ///< keeps a count for prescale
  
 };
 
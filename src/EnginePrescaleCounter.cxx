@@ -7,26 +7,63 @@
 #include "EnginePrescaleCounter.h"
 #include <assert.h>
 
-EnginePrescaleCounter::EnginePrescaleCounter(const std::vector<int>& prescales):m_prescales(prescales),m_useprescales(false){
-  if (!m_prescales.empty())m_useprescales=true;
-  for (int i=0;i<16;i++)m_counter[i]=0;
+EnginePrescaleCounter::EnginePrescaleCounter(const std::vector<int>& prescales):m_overrides(prescales){
+  for (int i=0;i<tableSize;i++)m_engine[i]=-1;
+}
+void EnginePrescaleCounter::configure(const Trigger::ConfigEngineTable& table){
+  // counters of engines that are still there are kept: reset() is separate
+  unsigned int engines=table.engines();
+  m_ordinal.resize(engines,0);
+  m_prescale.assign(engines,-1);
+  m_inhibited.assign(engines,1);
+  for (int i=0;i<tableSize;i++){
+    const Trigger::ConfigEngineTable::Entry& entry=table[i];
+    m_engine[i]=entry.engine;
+    if (entry.engine<0) continue;
+    // job option prescales override those of the configuration
+    m_prescale[entry.engine]= (unsigned)entry.engine<m_overrides.size() ? m_overrides[entry.engine] : entry.prescale;
+    m_inhibited[entry.engine]=entry.inhibited;
+  }
 }
 void EnginePrescaleCounter::reset(){
-  for (int i=0;i<16;i++)m_counter[i]=0;
+  m_ordinal.assign(m_ordinal.size(),0);
+}
+void EnginePrescaleCounter::seek(unsigned int engine, unsigned long long ordinal){
+  if (engine>=m_ordinal.size()) m_ordinal.resize(engine+1,0);
+  m_ordinal[engine]=ordinal;
+}
+unsigned long long EnginePrescaleCounter::ordinal(unsigned int engine)const{
+  return engine<m_ordinal.size() ? m_ordinal[engine] : 0;
+}
+bool EnginePrescaleCounter::pass(int engine, unsigned long long ordinal)const{
+  int prescale=m_prescale[engine];
+  if (prescale<0 || m_inhibited[engine]) return false;
+  return ordinal%(prescale+1)==(unsigned long long)prescale;
 }
   
-const bool EnginePrescaleCounter::decrementAndCheck(int condsummary, const TrgConfig *tcf){
-  int enginenumber=tcf->lut()->engineNumber(condsummary);
-  bool retval=false;
-  m_counter[enginenumber]--;
-  if (m_counter[enginenumber]<0){
-    if (m_useprescales){
-      assert((unsigned)enginenumber<m_prescales.size());//Not enough prescales defined for trigger engines
-      m_counter[enginenumber]=m_prescales[enginenumber];
-    }
-    else m_counter[enginenumber]=tcf->trgEngine()->prescale(enginenumber);
+const bool EnginePrescaleCounter::decrementAndCheck(int condsummary){
+  int enginenumber=m_engine[condsummary&(tableSize-1)];
+  assert(enginenumber>=0);//No engine for this condition summary
+  return pass(enginenumber, m_ordinal[enginenumber]++);
+}
+
+bool EnginePrescaleCounter::check(int condsummary, unsigned long long ordinal)const{
+  int enginenumber=m_engine[condsummary&(tableSize-1)];
+  assert(enginenumber>=0);//No engine for this condition summary
+  return pass(enginenumber, ordinal);
+}
+
+bool EnginePrescaleCounter::canPass(int condsummary, int unknownMask)const{
+  unknownMask &= tableSize-1;
+  int known = condsummary & (tableSize-1) & ~unknownMask;
+  for (int sub=unknownMask; ; sub=(sub-1)&unknownMask){ // every setting of the unknown bits
+    int engine=m_engine[known|sub];
+    if (engine>=0 && m_prescale[engine]>=0 && !m_inhibited[engine]) return true;
+    if (sub==0) break;
   }
-  if(m_counter[enginenumber]==0 && !tcf->trgEngine()->inhibited(enginenumber)) retval=true;
-  return retval;
+  return false;
 }
 
+void EnginePrescaleCounter::decrementAndCheck(const unsigned int* condsummaries, size_t count, bool* passed){
+  for (size_t i=0;i<count;i++) passed[i]=decrementAndCheck(condsummaries[i]);
+}
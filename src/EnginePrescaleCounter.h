@@ -7,22 +7,56 @@
 #ifndef EnginePrescaleCounter_h
 #define EnginePrescaleCounter_h
 
-#include "configData/gem/TrgConfig.h"
+#include "ConfigEngineTable.h"
+#include <vector>
+#include <cstddef>
 
+/** @class EnginePrescaleCounter
+    @brief prescale counters for the engines of a trigger configuration
+
+    The counter owns a snapshot of the engine selection, prescales and inhibits, taken
+    by configure() when the configuration changes. The per engine state is kept as
+    separate contiguous arrays indexed by engine number, sized to the configuration.
+
+    The state of an engine is its ordinal, the number of events seen for it: an event passes
+    when ordinal%(prescale+1)==prescale, which is the same as counting down from the prescale.
+    Since a decision only depends on the ordinal, it can be computed for any ordinal with
+    check(), and the ordinals can be set with seek(), e.g. to continue a partitioned job.
+*/
 class EnginePrescaleCounter{
  public:
-  /// Constructor with optional vector of prescales
+  /// Constructor with optional vector of prescales, overriding those of the configuration
   EnginePrescaleCounter(const std::vector<int>& prescales);
   /// Default destructor
   ~EnginePrescaleCounter(){}
+  /// take a snapshot of the engines, prescales and inhibits of a configuration
+  void configure(const Trigger::ConfigEngineTable& table);
   /// Reset the prescale counters
   void reset();
   /// decrement the counter for the engine corresponding to condsummary in the config, check for expiration
-  const bool decrementAndCheck(int condsummary, const TrgConfig *tcf);
+  const bool decrementAndCheck(int condsummary);
+  /// same for a block of condition summaries, in event order
+  void decrementAndCheck(const unsigned int* condsummaries, size_t count, bool* passed);
+  /// check the event with the given ordinal for the engine corresponding to condsummary; no change of state
+  bool check(int condsummary, unsigned long long ordinal)const;
+  /// true if some condition summary that differs from this one only in the bits of unknownMask
+  /// selects an engine that can pass: neither disabled (prescale<0) nor inhibited
+  bool canPass(int condsummary, int unknownMask)const;
+  /// set the ordinal of the next event for an engine
+  void seek(unsigned int engine, unsigned long long ordinal);
+  /// ordinal of the next event for an engine
+  unsigned long long ordinal(unsigned int engine)const;
+  /// number of engines with an ordinal
+  unsigned int engines()const{ return m_ordinal.size(); }
  private:
-  int m_counter[16];
-  const std::vector<int>& m_prescales;
-  int m_useprescales;
+  enum { tableSize = Trigger::ConfigEngineTable::tableSize };
+  int m_engine[tableSize];        ///< engine number for each condition summary, -1 if none
+  /// check an engine for an ordinal
+  bool pass(int engine, unsigned long long ordinal)const;
+  std::vector<unsigned long long> m_ordinal;  ///< per engine: events seen
+  std::vector<int>  m_prescale;   ///< per engine: prescale factor
+  std::vector<char> m_inhibited;  ///< per engine: inhibit flag
+  std::vector<int>  m_overrides;  ///< prescales from the job options, if any
 };
 
 #endif
@@ -0,0 +1,50 @@
+/** @file FswPrescaleCache.h
+  *  @brief Declaration of the class FswPrescaleCache
+  *
+  *  $Header:  $
+*/
+
+#ifndef Trigger_FswPrescaleCache_h
+#define Trigger_FswPrescaleCache_h
+
+#include "ConfigSvc/IConfigSvc.h"
+#include "configData/fsw/FswEfcSampler.h"
+
+#include <map>
+#include <utility>
+
+namespace Trigger {
+
+/** @class FswPrescaleCache
+    @brief the FSW prescaler information of a trigger configuration, by datagram mode and handler
+
+    The sampler and FMX key of a (mode, handler) are asked of the ConfigSvc once for each trigger
+    configuration, rather than for every event. An entry is not changed once made. The map is
+    not locked here: the owner holds a lock around entry() if events share the cache.
+*/
+class FswPrescaleCache {
+public:
+    struct Entry {
+        const FswEfcSampler*        efc;        ///< 0 if the configuration has none
+        unsigned                    fmxKey;     ///< FMX key of the configuration
+    };
+
+    /// the entry for a mode and handler, asked of the ConfigSvc the first time
+    Entry entry(IConfigSvc& configSvc, enums::Lsf::Mode mode, enums::Lsf::HandlerId handler){
+        std::pair<int,int> key(mode, handler);
+        std::map<std::pair<int,int>, Entry>::const_iterator it = m_entries.find(key);
+        if( it==m_entries.end() ){
+            Entry e;
+            e.fmxKey  = 0;
+            e.efc     = configSvc.getFSWPrescalerInfo(mode, handler, e.fmxKey);
+            it = m_entries.insert(std::make_pair(key, e)).first;
+        }
+        return it->second;
+    }
+
+private:
+    std::map<std::pair<int,int>, Entry>  m_entries;
+};
+
+}
+#endif
@@ -7,9 +7,14 @@
 
 #include "Trigger/ILivetimeSvc.h"
 
+#include "StateFile.h"
+
+#include "facilities/Util.h"
+
 
 #include "CLHEP/Random/RandFlat.h"
 #include "CLHEP/Random/RandPoisson.h"
+#include "CLHEP/Random/RanecuEngine.h"
 
 #include "GaudiKernel/Service.h"
 #include "GaudiKernel/SvcFactory.h"
@@ -17,11 +22,47 @@
 #include "GaudiKernel/SmartDataPtr.h"
 #include "GaudiKernel/MsgStream.h"
 
+#include <vector>
+#include <cmath>
+
+namespace {
+    /// number of rows of the seed table of RanecuEngine: larger indices wrap around to the same streams
+    const int ranecuStreams = 215;
+
+    /// a uniform in [0,1) that depends only on a clock count: the bits are mixed as by the
+    /// finalizer of SplitMix64, so that neighbouring counts give unrelated values
+    double tickUniform(unsigned long long tick)
+    {
+        unsigned long long x = tick + 0x9e3779b97f4a7c15ULL;
+        x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+        x = x ^ (x >> 31);
+        return double(x >> 11) * (1.0/9007199254740992.0); // 53 bits
+    }
+}
 
 /**@class LivetimeSvc
    @brief implement ILivetimeSvc interface
 
    Manage livetime
+
+   The random numbers of interleave mode come from the global CLHEP engine, or, if RandomStream
+   is set, from an engine owned by the service, one of the independent streams of RanecuEngine.
+   The uniforms of isLive are then generated in blocks.
+
+   In AnalyticMode no random numbers are used: the dead time of the invisible triggers is
+   accumulated as its expectation, with the Poisson variance, and isLive rejects the fraction
+   1-efficiency of the events deterministically, with a uniform made from the event time rather
+   than drawn: the decision of an event does not depend on the events before it.
+
+   The time of the last trigger and the deadtime intervals are kept as counts of the GEM clock,
+   so that each event time is converted once, and differences at mission elapsed time
+   magnitudes keep the resolution of the clock.
+
+   The state (last trigger, deadtime, livetime and counters) can be written at finalize to
+   StateOutput, and read at initialize from StateInput, to continue a previous time slice.
+   With RandomStream it includes the seeds of the engine, those of the current block of
+   uniforms and the position in it, so the continuation draws the numbers that one job would.
 */
 class LivetimeSvc :  public Service, 
         virtual public ILivetimeSvc
@@ -61,6 +102,13 @@ public:
  *          of the LAT system clock
  **/
   unsigned long long ticks(double time) const;
+
+    /// the clock counts of an event
+    virtual void tickSnapshot(double current_time, LivetimeTicks& snapshot) const;
+
+    /// checkState, isLive and tryToRegisterEvent for a block of events
+    virtual void registerEvents(const double* times, const bool* longdeadtime, size_t count,
+                                enums::GemState* states, bool* live, double* livetimes);
    
 private:
     /// Allow only SvcFactory to instantiate the service.
@@ -73,16 +121,50 @@ private:
     DoubleProperty m_deadtimelong; ///< deadtime per trigger for large events
     DoubleProperty m_frequency; ///< background trigger rate
     BooleanProperty  m_interleave;
+    IntegerProperty m_randomStream; ///< seed table index of the owned engine, -1 for the global one
+    BooleanProperty m_analytic;     ///< interleave mode from expectations, without random numbers
+    StringProperty m_stateInput;    ///< file to read the state from at initialize, "" for none
+    StringProperty m_stateOutput;   ///< file to write the state to at finalize, "" for none
+
+    /// copy the state to or from a state file; the keys that restoreState needs and does not
+    /// find are in state.missing()
+    void saveState(Trigger::StateFile& state) const;
+    void restoreState(Trigger::StateFile& state);
+
+    /// a uniform in (0,1) for isLive
+    double uniform();
+    /// a Poisson variate for the invisible triggers
+    double poisson(double mean);
+
+    CLHEP::RanecuEngine* m_engine;      ///< owned, 0 to use the global engine
+    std::vector<double> m_uniforms;     ///< block of uniforms from m_engine
+    size_t m_nextUniform;               ///< next unused in m_uniforms
+    long m_blockSeeds[2];               ///< seeds of m_engine that m_uniforms was made from
     double m_efficiency;
     double m_livetime; ///< update with request
     double m_totalTime;
 
     int m_total, m_accepted;
     int m_invisible_trig;
-    double m_lastTriggerTime;
+    double m_expected_invisible;  ///< analytic mode: expected number of invisible triggers
+    double m_livetimeVariance;    ///< analytic mode: variance of m_livetime
     double m_previousDeadtime; 
     enum state {live, deadzone, busy}; 
     double m_deadzoneTime;
+
+    /// nearest number of clock ticks to an interval
+    unsigned long long intervalTicks(double interval) const;
+
+    /// what tryToRegisterEvent, isLive and checkState do, for a time in ticks
+    bool registerAt(unsigned long long now, bool highdeadtime);
+    bool isLiveAt(unsigned long long now);
+    enums::GemState stateAt(unsigned long long now) const;
+
+    unsigned long long m_lastTriggerTick;      ///< time of the last registered event, 0 if none
+    unsigned long long m_previousDeadtimeTicks;///< deadtime of that event
+    unsigned long long m_deadtimeTicks;        ///< Deadtime
+    unsigned long long m_deadtimeLongTicks;    ///< DeadtimeLong
+    unsigned long long m_deadzoneTicks;
 };
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 // declare the service factories for the ntupleWriterSvc
@@ -94,13 +176,21 @@ DECLARE_SERVICE_FACTORY(LivetimeSvc);
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 LivetimeSvc::LivetimeSvc(const std::string& name,ISvcLocator* svc)
 : Service(name,svc)
+, m_engine(0)
+, m_nextUniform(0)
 , m_livetime(0)
 , m_totalTime(0)
 , m_total(0)
 , m_accepted(0)
 , m_invisible_trig(0)
-, m_lastTriggerTime(0)
+, m_expected_invisible(0)
+, m_livetimeVariance(0)
 , m_previousDeadtime(0)
+, m_lastTriggerTick(0)
+, m_previousDeadtimeTicks(0)
+, m_deadtimeTicks(0)
+, m_deadtimeLongTicks(0)
+, m_deadzoneTicks(0)
 {
     // declare the properties and set defaults
     declareProperty("Deadtime",    m_deadtime=26.45e-6 );  // deadtime to apply to trigger, in sec.
@@ -108,6 +198,10 @@ LivetimeSvc::LivetimeSvc(const std::string& name,ISvcLocator* svc)
     declareProperty("clockrate", m_frequency=20e6);  // 20 MHz clock
     declareProperty("TriggerRate", m_triggerRate=2000.);  // effective total trigger rate
     declareProperty("InterleaveMode", m_interleave=true);  // Apply efficiency correction?
+    declareProperty("RandomStream", m_randomStream=-1);  // own random stream for interleave mode, -1 for the global engine
+    declareProperty("AnalyticMode", m_analytic=false);  // interleave mode from expected dead time, no random numbers
+    declareProperty("StateInput", m_stateInput="");  // state file of a previous job to continue from
+    declareProperty("StateOutput", m_stateOutput="");  // state file to write at the end
 }
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 StatusCode LivetimeSvc::initialize () 
@@ -119,28 +213,82 @@ StatusCode LivetimeSvc::initialize ()
     // open the message log
     MsgStream log( msgSvc(), name() );
     m_deadzoneTime=100e-9; // 2 clock tick dead zone
+    m_deadtimeTicks     = intervalTicks(m_deadtime);
+    m_deadtimeLongTicks = intervalTicks(m_deadtimelong);
+    m_deadzoneTicks     = intervalTicks(m_deadzoneTime);
     m_efficiency = 1.0 - m_deadtime * m_triggerRate;
     if (m_interleave==true){
       log << MSG::INFO 
-	  << "Interleave mode. Applying efficiency of " << m_efficiency*100 << "%" << endreq;
+	  << "Interleave mode. Applying efficiency of " << m_efficiency*100 << "%" 
+	  << (m_analytic ? ", from expectations" : "") << endreq;
+    }else if (m_analytic==true){
+      log << MSG::WARNING << "AnalyticMode has no effect without InterleaveMode" << endreq;
+    }
+    if (m_randomStream>=ranecuStreams){
+      log << MSG::ERROR << "RandomStream " << m_randomStream.value() << " is not a RanecuEngine stream, 0 to "
+          << ranecuStreams-1 << endreq;
+      return StatusCode::FAILURE;
+    }
+    if (m_randomStream>=0){
+      m_engine = new CLHEP::RanecuEngine(m_randomStream);
+      m_uniforms.resize(256);
+      m_nextUniform = m_uniforms.size(); // first block on first use
+      m_blockSeeds[0] = m_engine->getSeeds()[0];
+      m_blockSeeds[1] = m_engine->getSeeds()[1];
+      log << MSG::INFO << "Using random stream " << m_randomStream.value() << endreq;
+    }
+    if (!m_stateInput.value().empty()){
+      std::string filename(m_stateInput.value());
+      facilities::Util::expandEnvVar(&filename);
+      Trigger::StateFile state(name() + ".");
+      if (!state.read(filename)){
+        log << MSG::ERROR << "could not read the state file " << filename << endreq;
+        return StatusCode::FAILURE;
+      }
+      restoreState(state);
+      if (!state.missing().empty()){
+        log << MSG::ERROR << "the state file " << filename << " has no";
+        for (size_t i=0; i<state.missing().size(); ++i) log << ' ' << state.missing()[i];
+        log << endreq;
+        return StatusCode::FAILURE;
+      }
+      log << MSG::INFO << "Continuing from the state in " << filename << endreq;
+    }
+    if ((!m_stateInput.value().empty() || !m_stateOutput.value().empty())
+        && m_engine==0 && m_interleave==true && m_analytic==false){
+      log << MSG::WARNING << "The global random engine is not part of the state: set RandomStream, "
+          << "or AnalyticMode, for the continuation to draw the numbers of a single job" << endreq;
     }
     return status;
 }
 
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 bool LivetimeSvc::tryToRegisterEvent(double current_time, bool highdeadtime)
+{ 
+   return registerAt(ticks(current_time), highdeadtime);
+}
+
+bool LivetimeSvc::registerAt(unsigned long long now, bool highdeadtime)
 { 
    ++m_total;
 
    if (m_deadtime<=0) return true;
-   bool live = current_time-m_lastTriggerTime >= m_previousDeadtime;
+   bool live = now >= m_lastTriggerTick+m_previousDeadtimeTicks;
    if( live ){
      // here if valid. Update the livetime
-     if( m_lastTriggerTime>0){
-       double elapsed(current_time-m_lastTriggerTime);
+     if( m_lastTriggerTick>0){
+       double elapsed(double(now-m_lastTriggerTick)/m_frequency);
        m_totalTime+= elapsed;
-       if(m_interleave==true){
-	 double ntrig( CLHEP::RandPoisson::shoot(elapsed*m_triggerRate));
+       if(m_interleave==true && m_analytic==true){
+	 // expected dead time of the invisible triggers, and its Poisson variance
+	 double ntrig(elapsed*m_triggerRate);
+	 m_expected_invisible+=ntrig;
+	 double livetimeinc=elapsed-m_previousDeadtime-ntrig*m_deadtime;
+	 if (livetimeinc<0)livetimeinc=0;
+	 else m_livetimeVariance+=ntrig*m_deadtime*m_deadtime;
+	 m_livetime += livetimeinc;
+       }else if(m_interleave==true){
+	 double ntrig( poisson(elapsed*m_triggerRate));
 	 m_invisible_trig+=(int)ntrig;
 	 double livetimeinc=elapsed-m_previousDeadtime-ntrig*m_deadtime;
 	 if (livetimeinc<0)livetimeinc=0;
@@ -149,11 +297,13 @@ bool LivetimeSvc::tryToRegisterEvent(double current_time, bool highdeadtime)
 	 m_livetime += elapsed-m_previousDeadtime;
        }
      }
-     m_lastTriggerTime = current_time;
+     m_lastTriggerTick = now;
      if (highdeadtime){
        m_previousDeadtime=m_deadtimelong;
+       m_previousDeadtimeTicks=m_deadtimeLongTicks;
      }else{
        m_previousDeadtime=m_deadtime;
+       m_previousDeadtimeTicks=m_deadtimeTicks;
      }
      ++m_accepted;
    }
@@ -162,24 +312,66 @@ bool LivetimeSvc::tryToRegisterEvent(double current_time, bool highdeadtime)
 
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 bool LivetimeSvc::isLive(double current_time)
+{
+  if (m_deadtime<=0) return true; // for backward compatibility
+  return isLiveAt(ticks(current_time));
+}
+
+bool LivetimeSvc::isLiveAt(unsigned long long now)
 {
   if (m_deadtime<=0) return true; // for backward compatibility
   bool live=true;
   if(m_interleave==true){
-    live = current_time-m_lastTriggerTime >= m_previousDeadtime;
-    if( live && m_efficiency<1.0){
+    live = now >= m_lastTriggerTick+m_previousDeadtimeTicks;
+    if( live && m_efficiency<1.0 && m_analytic==true){
+      // a function of the time, not of the order: periodic or interleaved sources are not favoured
+      if( tickUniform(now) > m_efficiency){
+	live=false;
+      }
+    }else if( live && m_efficiency<1.0){
       // put in random
-      double r = CLHEP::RandFlat::shoot();
+      double r = uniform();
       if( r > m_efficiency){
 	live=false;
       }
     }
   }else{
-    live = current_time-m_lastTriggerTime >= m_previousDeadtime;
+    live = now >= m_lastTriggerTick+m_previousDeadtimeTicks;
   }
   return live;
 }
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+void LivetimeSvc::registerEvents(const double* times, const bool* longdeadtime, size_t count,
+                                 enums::GemState* states, bool* live, double* livetimes)
+{
+  // one conversion of each time, and no virtual dispatch within the block
+  for (size_t i=0; i<count; ++i){
+    unsigned long long now = ticks(times[i]);
+    states[i] = stateAt(now);
+    live[i]   = isLiveAt(now);
+    if (live[i]) registerAt(now, longdeadtime[i]);
+    livetimes[i] = m_livetime;
+  }
+}
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+double LivetimeSvc::uniform()
+{
+  if (m_engine==0) return CLHEP::RandFlat::shoot();
+  if (m_nextUniform==m_uniforms.size()){
+    m_blockSeeds[0] = m_engine->getSeeds()[0];
+    m_blockSeeds[1] = m_engine->getSeeds()[1];
+    CLHEP::RandFlat::shootArray(m_engine, int(m_uniforms.size()), &m_uniforms[0]);
+    m_nextUniform=0;
+  }
+  return m_uniforms[m_nextUniform++];
+}
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+double LivetimeSvc::poisson(double mean)
+{
+  // the mean changes with every event, so these are not made in blocks
+  return m_engine==0 ? CLHEP::RandPoisson::shoot(mean) : CLHEP::RandPoisson::shoot(m_engine, mean);
+}
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 double LivetimeSvc::setTriggerRate(double rate)
 {
     double old = m_triggerRate;
@@ -189,11 +381,17 @@ double LivetimeSvc::setTriggerRate(double rate)
 }
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 enums::GemState LivetimeSvc::checkState(double current_time)
+{
+  if(m_deadtime<=0) return enums::LIVE;
+  return stateAt(ticks(current_time));
+}
+
+enums::GemState LivetimeSvc::stateAt(unsigned long long now) const
 {
   enums::GemState st;
   if(m_deadtime<=0) st=enums::LIVE;
-  else if (current_time-m_lastTriggerTime<=m_deadzoneTime)st=enums::DEADZONE;
-  else if (current_time-m_lastTriggerTime<=m_previousDeadtime)st=enums::BUSY;
+  else if (now<=m_lastTriggerTick+m_deadzoneTicks)st=enums::DEADZONE;
+  else if (now<=m_lastTriggerTick+m_previousDeadtimeTicks)st=enums::BUSY;
   else st=enums::LIVE;
   return st;
 }
@@ -222,17 +420,40 @@ StatusCode LivetimeSvc::queryInterface(const InterfaceID& riid, void** ppvInterf
 StatusCode LivetimeSvc::finalize ()
 {
     MsgStream log( msgSvc(), name() );
+    bool analytic = m_interleave==true && m_analytic==true;
     if( m_total>0 && m_deadtime>0){
         log << MSG::INFO 
             << "Processed " << m_total << " livetime requests, accepted "<< m_accepted 
-            << "\n\t\t\t  Invisible triggers generated: "<< m_invisible_trig 
-            << "\n\t\t\t                Total livetime: "<< m_livetime
-            << ", (" << int(100*m_livetime/m_totalTime+0.5) << "% of total)"
+            << "\n\t\t\t  Invisible triggers ";
+        if (analytic){
+            log << "expected: " << m_expected_invisible;   // none are generated
+        }else{
+            log << "generated: " << m_invisible_trig;
+        }
+        log << "\n\t\t\t                Total livetime: "<< m_livetime;
+        if (analytic){
+            log << " +- " << std::sqrt(m_livetimeVariance);
+        }
+        log << ", (" << int(100*m_livetime/m_totalTime+0.5) << "% of total)"
             <<  endreq;
     }
+    StatusCode sc = StatusCode::SUCCESS;
+    if (!m_stateOutput.value().empty()){
+      std::string filename(m_stateOutput.value());
+      facilities::Util::expandEnvVar(&filename);
+      Trigger::StateFile state(name() + ".");
+      saveState(state);
+      if (!state.write(filename)){
+        log << MSG::ERROR << "could not write the state file " << filename << endreq;
+        sc = StatusCode::FAILURE;
+      }
+    }
 
+    // after the state, which has its seeds
+    delete m_engine;
+    m_engine=0;
 
-    return StatusCode::SUCCESS;
+    return sc;
 }
 
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -242,4 +463,72 @@ unsigned long long LivetimeSvc::ticks(double time) const
   return (unsigned long long)(m_frequency * time);
 }
 
+unsigned long long LivetimeSvc::intervalTicks(double interval) const
+{
+  return interval>0 ? (unsigned long long)(m_frequency * interval + 0.5) : 0;
+}
 
+void LivetimeSvc::tickSnapshot(double current_time, LivetimeTicks& snapshot) const
+{
+  snapshot.time     = ticks(current_time);
+  snapshot.onePps   = ticks(std::floor(current_time));
+  snapshot.livetime = ticks(m_livetime);
+  snapshot.elapsed  = ticks(m_totalTime);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+void LivetimeSvc::saveState(Trigger::StateFile& state) const
+{
+  state.set("lastTriggerTick",       m_lastTriggerTick);
+  state.set("previousDeadtime",      m_previousDeadtime);
+  state.set("previousDeadtimeTicks", m_previousDeadtimeTicks);
+  state.set("livetime",              m_livetime);
+  state.set("elapsed",               m_totalTime);
+  state.set("total",                 m_total);
+  state.set("accepted",              m_accepted);
+  state.set("invisibleTriggers",     m_invisible_trig);
+  state.set("expectedInvisible",     m_expected_invisible);
+  state.set("livetimeVariance",      m_livetimeVariance);
+  if (m_engine!=0){
+    state.set("seeds.0",      m_engine->getSeeds()[0]);
+    state.set("seeds.1",      m_engine->getSeeds()[1]);
+    state.set("blockSeeds.0", m_blockSeeds[0]);
+    state.set("blockSeeds.1", m_blockSeeds[1]);
+    state.set("nextUniform",  m_nextUniform);
+  }
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+void LivetimeSvc::restoreState(Trigger::StateFile& state)
+{
+  state.require("lastTriggerTick",       m_lastTriggerTick);
+  state.require("previousDeadtime",      m_previousDeadtime);
+  state.require("previousDeadtimeTicks", m_previousDeadtimeTicks);
+  state.require("livetime",              m_livetime);
+  state.require("elapsed",               m_totalTime);
+  state.require("total",                 m_total);
+  state.require("accepted",              m_accepted);
+  state.require("invisibleTriggers",     m_invisible_trig);
+  state.require("expectedInvisible",     m_expected_invisible);
+  state.require("livetimeVariance",      m_livetimeVariance);
+  if (m_engine!=0){
+    size_t missing = state.missing().size();
+    long seeds[2] = {0, 0};
+    size_t next(m_uniforms.size());
+    state.require("seeds.0",      seeds[0]);
+    state.require("seeds.1",      seeds[1]);
+    state.require("blockSeeds.0", m_blockSeeds[0]);
+    state.require("blockSeeds.1", m_blockSeeds[1]);
+    state.require("nextUniform",  next);
+    if (state.missing().size()!=missing) return;
+    if (next>m_uniforms.size()) next = m_uniforms.size(); // not written by saveState: a new block
+
+    // make the current block again from its seeds, then continue from the seeds of the end
+    if (next<m_uniforms.size()){
+      m_engine->setSeeds(m_blockSeeds, m_randomStream.value());
+      CLHEP::RandFlat::shootArray(m_engine, int(m_uniforms.size()), &m_uniforms[0]);
+    }
+    m_engine->setSeeds(seeds, m_randomStream.value());
+    m_nextUniform = next;
+  }
+}
@@ -0,0 +1,50 @@
+/**
+*  @file Mutex.cxx
+*  @brief Implementation of the class Mutex
+*
+*  $Header:  $
+*/
+
+#include "Mutex.h"
+
+#ifdef WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+using namespace Trigger;
+
+#ifdef WIN32
+
+Mutex::Mutex() : m_impl(new CRITICAL_SECTION)
+{
+    InitializeCriticalSection(static_cast<CRITICAL_SECTION*>(m_impl));
+}
+
+Mutex::~Mutex()
+{
+    DeleteCriticalSection(static_cast<CRITICAL_SECTION*>(m_impl));
+    delete static_cast<CRITICAL_SECTION*>(m_impl);
+}
+
+void Mutex::lock()  { EnterCriticalSection(static_cast<CRITICAL_SECTION*>(m_impl)); }
+void Mutex::unlock(){ LeaveCriticalSection(static_cast<CRITICAL_SECTION*>(m_impl)); }
+
+#else
+
+Mutex::Mutex() : m_impl(new pthread_mutex_t)
+{
+    pthread_mutex_init(static_cast<pthread_mutex_t*>(m_impl), 0);
+}
+
+Mutex::~Mutex()
+{
+    pthread_mutex_destroy(static_cast<pthread_mutex_t*>(m_impl));
+    delete static_cast<pthread_mutex_t*>(m_impl);
+}
+
+void Mutex::lock()  { pthread_mutex_lock(static_cast<pthread_mutex_t*>(m_impl)); }
+void Mutex::unlock(){ pthread_mutex_unlock(static_cast<pthread_mutex_t*>(m_impl)); }
+
+#endif
@@ -0,0 +1,45 @@
+/** @file Mutex.h
+  *  @brief Declaration of the class Mutex
+  *
+  *  $Header:  $
+*/
+
+#ifndef Trigger_Mutex_h
+#define Trigger_Mutex_h
+
+namespace Trigger {
+
+/** @class Mutex
+    @brief a lock for the few steps that change an algorithm shared by concurrent events
+
+    Such as making the tables of a trigger configuration the first time it is seen. Held with
+    a Mutex::Lock for the scope of the step. A pthread mutex, or a critical section on Windows.
+*/
+class Mutex {
+public:
+    Mutex();
+    ~Mutex();
+
+    void lock();
+    void unlock();
+
+    /// holds the mutex until the end of its scope
+    class Lock {
+    public:
+        explicit Lock(Mutex& mutex) : m_mutex(mutex) { m_mutex.lock(); }
+        ~Lock(){ m_mutex.unlock(); }
+    private:
+        Lock(const Lock&);
+        Lock& operator=(const Lock&);
+        Mutex& m_mutex;
+    };
+
+private:
+    Mutex(const Mutex&);
+    Mutex& operator=(const Mutex&);
+
+    void* m_impl;  ///< the system's mutex
+};
+
+}
+#endif
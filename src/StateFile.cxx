@@ -0,0 +1,59 @@
+/**
+*  @file StateFile.cxx
+*  @brief Implementation of the class StateFile
+*
+*  $Header:  $
+*/
+
+#include "StateFile.h"
+
+#include <fstream>
+
+using namespace Trigger;
+
+namespace {
+    typedef std::map<std::string, std::string> Values;
+
+    /// the key value lines of a file, false if it cannot be read
+    bool readValues(const std::string& filename, Values& values)
+    {
+        std::ifstream in(filename.c_str());
+        if( !in ) return false;
+
+        std::string line;
+        while( std::getline(in, line) ){
+            std::istringstream fields(line);
+            std::string key, value;
+            if( !(fields >> key >> value) || key[0]=='#' ) continue;
+            values[key] = value;
+        }
+        return true;
+    }
+}
+
+//------------------------------------------------------------------------------
+bool StateFile::read(const std::string& filename)
+{
+    m_values.clear();
+    m_missing.clear();
+    return readValues(filename, m_values);
+}
+
+//------------------------------------------------------------------------------
+bool StateFile::write(const std::string& filename)const
+{
+    // keep what other components wrote to the file; a file that does not exist yet has none
+    Values values;
+    readValues(filename, values);
+    for( Values::iterator it = values.begin(); it!=values.end(); ){
+        if( it->first.compare(0, m_prefix.size(), m_prefix)==0 ) values.erase(it++);
+        else ++it;
+    }
+    values.insert(m_values.begin(), m_values.end());
+
+    std::ofstream out(filename.c_str());
+    for( Values::const_iterator it = values.begin(); it!=values.end(); ++it){
+        out << it->first << ' ' << it->second << '\n';
+    }
+    return !out.fail();
+}
@@ -0,0 +1,77 @@
+/** @file StateFile.h
+  *  @brief Declaration of the class StateFile
+  *
+  *  $Header:  $
+*/
+
+#ifndef Trigger_StateFile_h
+#define Trigger_StateFile_h
+
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace Trigger {
+
+/** @class StateFile
+    @brief the state of a trigger component, as "key value" lines in a text file
+
+    Written at the end of a job and read at the start of the next, so that jobs over successive
+    time slices continue from each other: deadtime, livetime and prescale counters.
+    Doubles are written with full precision, so that a state read back is the state written.
+    The slices are then run one after the other: a state is only known once the slice before ends.
+
+    The keys of a component start with its prefix (its name and a dot), so that several
+    components can share a file: write replaces only the lines of its own prefix.
+*/
+class StateFile {
+public:
+    explicit StateFile(const std::string& prefix="") : m_prefix(prefix) {}
+
+    /// read a file, replacing the values; false if it cannot be read
+    bool read(const std::string& filename);
+
+    /// write the values, one per line in key order, with the lines of other prefixes already
+    /// in the file; false if the file cannot be written
+    bool write(const std::string& filename)const;
+
+    template <class T>
+    void set(const std::string& key, const T& value){
+        std::ostringstream out;
+        out.precision(17);
+        out << value;
+        m_values[m_prefix+key] = out.str();
+    }
+
+    /// set value from key, if present and readable as a T
+    template <class T>
+    bool get(const std::string& key, T& value)const{
+        std::map<std::string, std::string>::const_iterator it = m_values.find(m_prefix+key);
+        if( it==m_values.end() ) return false;
+        std::istringstream in(it->second);
+        T v;
+        if( !(in >> v) ) return false;
+        value = v;
+        return true;
+    }
+
+    /// get a value that must be present: the key is added to missing() if it is not
+    template <class T>
+    void require(const std::string& key, T& value){
+        if( !get(key, value) ) m_missing.push_back(m_prefix+key);
+    }
+
+    /// the keys that require did not find
+    const std::vector<std::string>& missing()const{ return m_missing; }
+
+    bool empty()const{ return m_values.empty(); }
+
+private:
+    std::string                        m_prefix;
+    std::map<std::string, std::string> m_values;
+    std::vector<std::string>           m_missing;
+};
+
+}
+#endif
@@ -0,0 +1,53 @@
+/** @file TdsHandle.h
+  *  @brief Declaration of the class template TdsHandle
+  *
+  *  $Header:  $
+*/
+
+#ifndef Trigger_TdsHandle_h
+#define Trigger_TdsHandle_h
+
+#include "GaudiKernel/IDataProviderSvc.h"
+#include "GaudiKernel/SmartDataPtr.h"
+
+#include <string>
+
+namespace Trigger {
+
+/** @class TdsHandle
+    @brief an algorithm's access to one TDS location
+
+    The path and the data service are bound once, at initialize. find() looks the object up
+    and changes nothing, so that the events of an algorithm that keeps no state from one to
+    the next can share the handle. The lookups can be counted in a counter of the event.
+*/
+template <class T>
+class TdsHandle {
+public:
+    explicit TdsHandle(const std::string& path)
+        : m_path(path), m_svc(0) {}
+
+    /// bind the data service
+    void initialize(IDataProviderSvc* svc){ m_svc=svc; }
+
+    /// the object, 0 if not in the TDS
+    T* find()const{
+        SmartDataPtr<T> object(m_svc, m_path);
+        return object;
+    }
+
+    /// the same, counting the lookup
+    T* find(unsigned int& lookups)const{
+        ++lookups;
+        return find();
+    }
+
+    const std::string& path()const{ return m_path; }
+
+private:
+    std::string       m_path;
+    IDataProviderSvc* m_svc;
+};
+
+}
+#endif
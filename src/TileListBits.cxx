@@ -0,0 +1,40 @@
+/**
+*  @file TileListBits.cxx
+*  @brief Implementation of the class TileListBits
+*
+*  $Header:  $
+*/
+
+#include "TileListBits.h"
+
+using namespace Trigger;
+
+void TileListBits::toTileList(Event::TriggerInfo::TileList& tileList)const
+{
+    // in key order, so that each insert goes at the end
+    tileList.clear();
+    Event::TriggerInfo::TileList::iterator end = tileList.end();
+    tileList.insert(end, std::make_pair(std::string("na"),  na()));
+    tileList.insert(end, std::make_pair(std::string("rbn"), rbn()));
+    tileList.insert(end, std::make_pair(std::string("xy"),  xy()));
+    tileList.insert(end, std::make_pair(std::string("xzm"), xzm()));
+    tileList.insert(end, std::make_pair(std::string("xzp"), xzp()));
+    tileList.insert(end, std::make_pair(std::string("yzm"), yzm()));
+    tileList.insert(end, std::make_pair(std::string("yzp"), yzp()));
+}
+
+void TileListBits::fromTileList(const Event::TriggerInfo::TileList& tileList)
+{
+    clear();
+    for( Event::TriggerInfo::TileList::const_iterator it = tileList.begin(); it!=tileList.end(); ++it){
+        const std::string& name = it->first;
+        unsigned int value = it->second;
+        if     ( name=="xzm" ) m_word[0] |= value & 0xffff;
+        else if( name=="xzp" ) m_word[0] |= (value & 0xffff)<<16;
+        else if( name=="yzm" ) m_word[1] |= value & 0xffff;
+        else if( name=="yzp" ) m_word[1] |= (value & 0xffff)<<16;
+        else if( name=="xy"  ) m_word[2] |= value & 0x1ffffff;
+        else if( name=="rbn" ) m_word[3] |= value & 0xff;
+        else if( name=="na"  ) m_word[3] |= (value & 0x7ff)<<16;
+    }
+}
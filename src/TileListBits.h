@@ -0,0 +1,60 @@
+/** @file TileListBits.h
+  *  @brief Declaration of the class TileListBits
+  *
+  *  $Header:  $
+*/
+
+#ifndef Trigger_TileListBits_h
+#define Trigger_TileListBits_h
+
+#include "Event/Trigger/TriggerInfo.h"
+
+namespace Trigger {
+
+/** @class TileListBits
+    @brief the GEM veto tile list as a fixed 128-bit set, indexed by GEM tile index
+
+    The GEM tile list words are sub-fields of the set:
+    @verbatim
+      xzm  0- 15    xzp  16- 31    yzm 32-47    yzp 48-63
+      xy  64- 88    rbn  96-103    na 112-122
+    @endverbatim
+    Event::TriggerInfo keeps the same information in a map keyed by the word names:
+    toTileList() and fromTileList() convert for the TDS.
+*/
+class TileListBits {
+public:
+    TileListBits(){ clear(); }
+
+    void clear(){ m_word[0]=m_word[1]=m_word[2]=m_word[3]=0; }
+
+    /// true if the GEM tile index falls in one of the tile list words
+    static bool valid(unsigned int gemIndex){
+        return gemIndex<89 || (gemIndex>=96 && gemIndex<104) || (gemIndex>=112 && gemIndex<123);
+    }
+
+    /// set the bit for a (valid) GEM tile index
+    void set(unsigned int gemIndex){ m_word[gemIndex>>5] |= 1u<<(gemIndex&31); }
+
+    bool empty()const{ return (m_word[0]|m_word[1]|m_word[2]|m_word[3])==0; }
+
+    unsigned short xzm()const{ return m_word[0]&0xffff; }
+    unsigned short xzp()const{ return m_word[0]>>16; }
+    unsigned short yzm()const{ return m_word[1]&0xffff; }
+    unsigned short yzp()const{ return m_word[1]>>16; }
+    unsigned int   xy() const{ return m_word[2]&0x1ffffff; }
+    unsigned short rbn()const{ return m_word[3]&0xff; }
+    unsigned short na() const{ return (m_word[3]>>16)&0x7ff; }
+
+    /// fill the map of Event::TriggerInfo
+    void toTileList(Event::TriggerInfo::TileList& tileList)const;
+
+    /// set from the map of Event::TriggerInfo
+    void fromTileList(const Event::TriggerInfo::TileList& tileList);
+
+private:
+    unsigned int m_word[4];
+};
+
+}
+#endif
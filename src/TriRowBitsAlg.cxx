@@ -9,6 +9,7 @@
 // set the following define to compile Johann's code for special trigger bit diagnostics
 // or better, move it to its own algorithm, as it is not involved in computing trigger bits itself.
 #include "Trigger/TriRowBits.h"
+#include "Trigger/TkrLayerBits.h"
 
 #include "GlastSvc/GlastDetSvc/IGlastDetSvc.h"
 
@@ -30,28 +31,19 @@
 #include "GaudiKernel/SmartDataPtr.h"
 #include "GaudiKernel/StatusCode.h"
 
+#include "TdsHandle.h"
+
 
 #include <map>
 #include <vector>
 
-namespace { // local definitions of convenient inline functions
-    inline unsigned three_in_a_row(unsigned bits)
-    {
-        unsigned bitword = 0;
-        for(int i=0; i<16; i++){
-            if((bits&7)==7)  bitword |= 1 << i;
-            bits >>= 1;
-        }
-        return bitword;
-    }
-    inline unsigned layer_bit(int layer){ return 1 << layer;}
-}
 //------------------------------------------------------------------------------
 /*! \class TriRowBitsAlg
 \brief  alg that calculates the TriRowBits from TKR digis and diagnostics
 
 @section Attributes for job options:
 
+Nothing in the algorithm is changed by an event.
 */
 
 class TriRowBitsAlg : public Algorithm {
@@ -66,11 +58,14 @@ public:
 
 private:
 
-    void computeTrgReqTriRowBits(TriRowBitsTds::TriRowBits&);
+    /// the 3 in a row combinations from the trigger requests of the diagnostic data, if any
+    void computeTrgReqTriRowBits(LdfEvent::DiagnosticData* diagTds, TriRowBitsTds::TriRowBits&)const;
 
     /// access to the Glast Detector Service to read in geometry constants from XML files
     IGlastDetSvc *m_glastDetSvc;
 
+    Trigger::TdsHandle<TriRowBitsTds::TriRowBits>   m_triRowBits;
+    Trigger::TdsHandle<LdfEvent::DiagnosticData>    m_diagnostic;
 
 };
 
@@ -82,6 +77,9 @@ DECLARE_ALGORITHM_FACTORY(TriRowBitsAlg);
 /// 
 TriRowBitsAlg::TriRowBitsAlg(const std::string& name, ISvcLocator* pSvcLocator) 
 : Algorithm(name, pSvcLocator)
+, m_glastDetSvc(0)
+, m_triRowBits("/Event/TriRowBits")
+, m_diagnostic("/Event/Diagnostic")
 {
 
 
@@ -99,6 +97,9 @@ StatusCode TriRowBitsAlg::initialize()
     // Use the Job options service to set the Algorithm's parameters
     setProperties();
 
+    m_triRowBits.initialize(eventSvc());
+    m_diagnostic.initialize(eventSvc());
+
     m_glastDetSvc = 0;
     sc = service("GlastDetSvc", m_glastDetSvc, true);
     if (sc.isSuccess() ) {
@@ -125,68 +126,35 @@ StatusCode TriRowBitsAlg::execute()
     MsgStream   log( msgSvc(), name() );
 
     // testing for existing TriRowBits object in the TDS
-    SmartDataPtr<TriRowBitsTds::TriRowBits> trirowbits(eventSvc(), "/Event/TriRowBits");
-    if(trirowbits!=0) {
+    if(m_triRowBits.find()!=0) {
         // nothing to do here
         return StatusCode::SUCCESS;
     }    
 
-    SmartDataPtr<Event::TkrDigiCol> planes(eventSvc(), EventModel::Digi::TkrDigiCol);
-    if( planes==0 ) {
+    // the layer bits are shared with TriggerInfoAlg: made from the TkrDigi collection by the first to need them
+    const TriRowBitsTds::TkrLayerBits* layerBits = TriRowBitsTds::TkrLayerBits::get(eventSvc());
+    if( layerBits==0 ) {
         log << MSG::DEBUG << "No tkr digis found" << endreq;
         return StatusCode::SUCCESS;
     }
 
-    // purpose and method: determine if there is tracker trigger, any 3-in-a-row, 
-    //and fill out the TDS class TriRowBits, with the complete 3-in-a-row information
-
-    log << MSG::DEBUG << planes->size() << " tracker planes found with hits" << endreq;
-
-    // define a map to sort hit planes according to tower and plane axis
-    typedef std::pair<idents::TowerId, idents::GlastAxis::axis> Key;
-    typedef std::map<Key, unsigned int> Map;
-    Map layer_bits;
-
-    // this loop sorts the hits by setting appropriate bits in the tower-plane hit map
-    for( Event::TkrDigiCol::const_iterator it = planes->begin(); it != planes->end(); ++it){
-        const Event::TkrDigi& t = **it;
-        if( t.getNumHits()== 0) continue; // this can happen if there are dead strips 
-        layer_bits[std::make_pair(t.getTower(), t.getView())] |= layer_bit(t.getBilayer());
-    }
-
-
     //! Wasn't in TDS, so creating it.
     //!Documentation of three_in_a_row_bits available in Trigger/TriRowBits.h
     TriRowBitsTds::TriRowBits *rowbits= new TriRowBitsTds::TriRowBits;
-    sc = eventSvc()->registerObject("/Event/TriRowBits", rowbits);
+    sc = eventSvc()->registerObject(m_triRowBits.path(), rowbits);
     if (sc.isFailure()) {
         log << MSG::ERROR << "Failed to register TriRowBits on the TDS" << endreq;
         log << MSG::ERROR << "This is an error that needs to be fixed" << endreq;
         return StatusCode::FAILURE;
     }
 
-    //bool tkr_trig_flag = false;
-    // now look for a three in a row in x-y coincidence
-    for( Map::iterator itr = layer_bits.begin(); itr !=layer_bits.end(); ++ itr){
-
-        Key theKey=(*itr).first;
-        idents::TowerId tower = theKey.first;
-        if( theKey.second==idents::GlastAxis::X) {
-            // found an x: and with corresponding Y (if exists)
-            unsigned int
-                xbits = (*itr).second,
-                ybits = layer_bits[std::make_pair(tower, idents::GlastAxis::Y)];
-
-            //!Calculating the TriRowBits - 16 possible 3-in-a-row signals for 18 layers
-            unsigned int bitword=three_in_a_row(xbits & ybits);
-            rowbits->setDigiTriRowBits(tower.id(), bitword);
-
-
-        }
+    //!Calculating the TriRowBits - 16 possible 3-in-a-row signals for 18 layers
+    for(unsigned int tower=0; tower<NUM_TWRS; ++tower){
+        rowbits->setDigiTriRowBits(tower, layerBits->getTriRowBits(tower));
     }
 
     //Now we compute the 3 in a row combinations based on the trigger requests
-    computeTrgReqTriRowBits(*rowbits);
+    computeTrgReqTriRowBits(m_diagnostic.find(), *rowbits);
 
 
     log << MSG::DEBUG;
@@ -207,11 +175,9 @@ StatusCode TriRowBitsAlg::finalize() {
 }
 
 
-void TriRowBitsAlg::computeTrgReqTriRowBits(TriRowBitsTds::TriRowBits& rowbits)
+void TriRowBitsAlg::computeTrgReqTriRowBits(LdfEvent::DiagnosticData* diagTds, TriRowBitsTds::TriRowBits& rowbits)const
 {
-    // Retrieve the Diagnostic data for this event
-    // note: here we would also have access to the CAL diagnostic data.
-    SmartDataPtr<LdfEvent::DiagnosticData> diagTds(eventSvc(), "/Event/Diagnostic");
+    // note: the Diagnostic data would also give access to the CAL diagnostic data.
 
     static const unsigned int NUM_TWR = 16; //this should come from the geometry.
 
@@ -12,12 +12,25 @@
 
 #include "TriggerTables.h"
 #include "EnginePrescaleCounter.h"
+#include "ConfigEngineTable.h"
+#include "TileListBits.h"
+#include "TriggerPrimitives.h"
+#include "AcdTileTable.h"
+#include "TdsHandle.h"
+#include "TriggerBitHistogram.h"
+#include "FswPrescaleCache.h"
+#include "StateFile.h"
+#include "Mutex.h"
 #include "configData/fsw/FswEfcSampler.h"
 
 #include "Event/TopLevel/EventModel.h"
 #include "Event/TopLevel/Event.h"
 #include "Event/TopLevel/DigiEvent.h"
 #include "Event/Trigger/TriggerInfo.h"
+#include "Event/Digi/AcdDigi.h"
+
+#include "Trigger/TkrLayerBits.h"
+#include "Trigger/PrimitiveStatus.h"
 
 #include "LdfEvent/Gem.h"
 #include "LdfEvent/LsfMetaEvent.h"
@@ -28,6 +41,8 @@
 #include "idents/AcdId.h"
 #include "idents/TowerId.h"
 
+#include "CalXtalResponse/ICalTrigTool.h"
+
 #include "facilities/Util.h"
 
 #include "GaudiKernel/MsgStream.h"
@@ -39,8 +54,19 @@
 
 #include <cassert>
 #include <map>
+#include <set>
 #include <vector>
 #include <algorithm>
+#include <stdexcept>
+#include <fstream>
+
+namespace {
+    /// ticks from last to now, for the GEM delta times: 0xffff if too many, or if now is before last
+    unsigned short deltaTicks(unsigned long long now, unsigned long long last)
+    {
+        return now>=last && now-last<0xffff ? (unsigned short)(now-last) : 0xffff;
+    }
+}
 
 //------------------------------------------------------------------------------
 /*! \class TriggerAlg
@@ -50,6 +76,19 @@
 @param run [0] For setting the run number
 @param mask [-1] mask to apply to trigger word. -1 means any, 0 means all.
 
+Each event goes through configure, which finds the tables made from its ConfigSvc configuration
+(see Configuration), making them when the configuration is first seen; classify, which finds
+the primitives, condition summaries and engines with those tables and changes nothing in the
+algorithm; sequence, which holds everything that depends on the order of the events (prescale
+counters and the configuration they follow, deadtime, the last trigger and window times,
+statistics); and fill, which makes the objects of the event from what the other two found.
+Only sequence must see the events in order: fill changes the algorithm only under a lock, like
+configure (the FSW prescaler entries of a configuration, and the FMX key mismatches reported).
+
+If TriggerInfoAlg skipped the calorimeter primitives of an event (its lazyPrimitives option, see
+Trigger::PrimitiveStatus), they are computed here unless the window mask and engines of this
+algorithm reject the event whatever they are, and the TriggerInfo is completed. Events that are
+rejected without them are counted in the statistics without calorimeter bits.
 */
 
 class TriggerAlg : public Algorithm {
@@ -64,20 +103,115 @@ public:
 
 private:
 
-    void bitSummary(std::ostream& out, std::string label, const std::map<unsigned int,unsigned int>& table);
+    /// what is derived from a ConfigSvc trigger configuration: made when the configuration is
+    /// first seen and not changed after, so that an event classified with it can be sequenced
+    /// and filled after events of other configurations. The FSW prescaler entries are added
+    /// as the datagram modes are met, under m_configurationLock, and not changed after either
+    struct Configuration
+    {
+        unsigned                     mootKey;
+        const TrgConfig*             tcf;          ///< for the printout of the configuration
+        Trigger::ConfigEngineTable   engineTable;  ///< engine of each condition summary
+        EnginePrescaleCounter        engines;      ///< for calorimeterNeeded: only canPass is used
+        unsigned int                 windowMask;
+        const Trigger::AcdTileTable* acdTiles;     ///< with computePrimitives, otherwise 0
+        mutable Trigger::FswPrescaleCache fswPrescales; ///< for the MetaEvent, under m_configurationLock
+
+        Configuration(unsigned key, const TrgConfig& config, const std::vector<int>& prescales, bool withAcdTiles);
+        ~Configuration(){ delete acdTiles; }
+    private:
+        Configuration(const Configuration&);
+        Configuration& operator=(const Configuration&);
+    };
+
+    /// what the classification stage finds for an event: it depends only on the event and
+    /// its trigger configuration, so events can be classified in any order
+    struct Classification
+    {
+        const Configuration*               config;        ///< ConfigSvc configuration of the event, 0 if none
+        Trigger::TriggerPrimitives::Values primitives;
+        Event::EventHeader*                header;
+        LdfEvent::Gem*                     gem;           ///< 0 if the event has none (yet)
+        Event::TriggerInfo*                triggerInfo;   ///< from TriggerInfoAlg, 0 with computePrimitives
+        Trigger::PrimitiveStatus*          primitiveStatus; ///< from TriggerInfoAlg with lazyPrimitives, else 0
+        bool                               calorimeterAdded; ///< the calorimeter primitives skipped by TriggerInfoAlg were computed here
+        unsigned int                       lookups;       ///< TDS lookups of configure and classify
+        bool                               isMc;
+        bool                               windowOpen;    ///< passes the window mask, if applied
+        unsigned int                       gltword;       ///< GEM conditions from the trigger bits
+        unsigned int                       gemword;       ///< condition summary of the GEM, or gltword
+        unsigned int                       prescaleword;  ///< selects the engine that is prescaled: gemword for data, unless useGltWordForData
+        int                                gemengine;
+        int                                gltengine;
+        int                                gemprescale;
+        int                                gltprescale;
+        bool                               longdeadtime;  ///< four-range readout, with ConfigSvc
+        bool                               throttled;     ///< vetoed by the throttle, without engines
+    };
+
+    /// what the sequencing stage finds for an event that triggers
+    struct Sequence
+    {
+        double             now;
+        LivetimeTicks      ticks;      ///< GEM clock counts of the event
+        unsigned short     deltaEventTime;
+        unsigned short     deltaWindowOpenTime;
+        double             livetime;   ///< since the first trigger, less deadtime if applied
+        unsigned long long prescaled;  ///< GEM scalers
+        unsigned long long busy;
+        unsigned long long deadzone;
+    };
+
+    /// find the configuration of the event from the ConfigSvc, making its tables when it is first
+    /// seen, and the CalTrigTool when skipped calorimeter primitives are first found: the only
+    /// step that changes the algorithm outside sequence, under m_configurationLock
+    StatusCode configure(Classification& event, MsgStream& log);
+
+    /// retrieve the CalTrigTool for m_primitives, if not yet done
+    StatusCode retrieveCalTrigTool(MsgStream& log);
+
+    /// the primitives, condition summaries and engines of an event: changes nothing here
+    StatusCode classify(Classification& event, MsgStream& log)const;
+
+    /// trigger bits that open the window, when the window mask is applied
+    unsigned int windowMask(const Classification& event)const;
+
+    /// false if the event is rejected whatever its calorimeter primitives, by the window mask or
+    /// by engines that are all disabled or inhibited
+    bool calorimeterNeeded(const Classification& event, unsigned int trigger_bits)const;
+
+    /// the steps that depend on the previous events, in event order: prescale counters and the
+    /// configuration they follow, deadtime, times of the last trigger and window, and the statistics.
+    /// @return true if the event triggers
+    bool sequence(const Classification& event, Sequence& sequenced, MsgStream& log);
+
+    /// register or complete the TriggerInfo as needed; for an event that triggers, also set the
+    /// trigger words of the header, and make the GEM and MetaEvent objects as needed
+    StatusCode fill(const Classification& event, const Sequence& sequenced, bool triggered, MsgStream& log);
+
+    void bitSummary(std::ostream& out, std::string label, const Trigger::TriggerBitHistogram& table);
     /// input is a list of tiles, output is LdfEvent::GemTileList object
-    void makeGemTileList(const Event::TriggerInfo::TileList& tilelist, LdfEvent::GemTileList& vetotilelist);
-    /// set gem bits in trigger word, either from real condition summary, or from bits
-    unsigned int gemBits(unsigned int  trigger_bits);
+    void makeGemTileList(const Trigger::TileListBits& tilelist, LdfEvent::GemTileList& vetotilelist);
 
     //! add the FSW prescale values and MOOT Key to the meta event
-    StatusCode handleMetaEvent( LsfEvent::MetaEvent& metaEvent, unsigned int triggerEngine );
+    StatusCode handleMetaEvent( LsfEvent::MetaEvent& metaEvent, unsigned int triggerEngine, const Configuration* config );
 
     //! map the engine to the DGN prescaler
     enums::Lsf::LeakedPrescaler dgnPrescaler(unsigned engine);
 
     /// Check the FMX keys from MOOT against those from event data, return false if we should fail the job
-    bool checkFmxKey(unsigned mootKey, unsigned evtKey, enums::Lsf::Mode, enums::Lsf::HandlerId) const;
+    /// (each mismatch is reported once, under m_fmxWarnedLock)
+    bool checkFmxKey(unsigned mootKey, unsigned evtKey, enums::Lsf::Mode, enums::Lsf::HandlerId);
+
+    /// set the prescale factor of a handler from the FSW prescaler info of the configuration (unchanged
+    /// if none), return false if we should fail the job on its FMX key
+    bool fswPrescaleFactor(const Configuration& config, enums::Lsf::Mode mode, enums::Lsf::HandlerId handler, unsigned cfgKey,
+                           enums::Lsf::RsdState state, enums::Lsf::LeakedPrescaler sampler, unsigned& factor);
+
+    /// copy the state that the next time slice continues from to or from a state file;
+    /// the keys that restoreState needs and does not find are in state.missing()
+    void saveState(Trigger::StateFile& state)const;
+    void restoreState(Trigger::StateFile& state);
     
     unsigned int                        m_mask;
     int                                 m_acd_hits;
@@ -95,12 +229,18 @@ private:
     StringProperty                      m_table;
     StringProperty                      m_maskProperty;
     IntegerArrayProperty                m_prescale;
+    IntegerArrayProperty                m_prescaleSeek;
+    BooleanProperty                     m_computePrimitives;   //! compute the primitives here, not in TriggerInfoAlg
+    BooleanProperty                     m_registerTriggerInfo; //! with computePrimitives, register the TriggerInfo for all events
+    StringProperty                      m_towersOnProperty;    //! with computePrimitives, as TriggerInfoAlg
+    StringProperty                      m_bilayersOnProperty;
 
-    double                              m_lastTriggerTime; //! time of last trigger, for delta window time
-    double                              m_lastWindowTime;  //! time of last trigger window, for delta window open time
+    unsigned long long                  m_lastTriggerTick; //! GEM clock at last trigger, for delta event time
+    unsigned long long                  m_lastWindowTick;  //! GEM clock at last trigger window, for delta window open time
 
     // for statistics
     unsigned int                        m_total;
+    unsigned long long                  m_lookups;  //! TDS lookups of the sequenced events
     unsigned int                        m_triggered;
     unsigned int                        m_deadtime_reject;
     unsigned int                        m_window_reject;
@@ -108,10 +248,14 @@ private:
     unsigned long long                  m_busy;
     unsigned long long                  m_deadzone;
 
-    std::map<unsigned int,unsigned int> m_counts;           //map of values for each bit pattern
-    std::map<unsigned int,unsigned int> m_window_counts;    //map of values for each bit pattern, window mask applied
-    std::map<unsigned int,unsigned int> m_prescaled_counts; //map of values for each bit pattern, after prescaling
-    std::map<unsigned int,unsigned int> m_trig_counts;      //map of values for each bit pattern, triggered events
+    Trigger::TriggerBitHistogram        m_counts;           //counts for each bit pattern
+    Trigger::TriggerBitHistogram        m_window_counts;    //counts for each bit pattern, window mask applied
+    Trigger::TriggerBitHistogram        m_prescaled_counts; //counts for each bit pattern, after prescaling
+    Trigger::TriggerBitHistogram        m_trig_counts;      //counts for each bit pattern, triggered events
+    StringProperty                      m_summaryFile;      //file for the counts, "" for none
+    StringProperty                      m_summaryReference; //summaryFile of another job that the triggered counts must match, "" for none
+    StringProperty                      m_stateInput;       //state file to continue from, "" for none
+    StringProperty                      m_stateOutput;      //state file to write at finalize, "" for none
 
     std::map<idents::TowerId, int>      m_tower_trigger_count;
 
@@ -122,12 +266,36 @@ private:
     Trigger::TriggerTables*             m_triggerTables;
     IConfigSvc*                         m_configSvc;
     EnginePrescaleCounter*              m_pcounter;
+    Trigger::TriggerPrimitives          m_primitives;   //! with computePrimitives, or for skipped calorimeter primitives
+    ICalTrigTool*                       m_calTrigTool;  //! for m_primitives, 0 until one of those needs it
+    const Trigger::AcdTileTable*        m_acdTiles;     //! ACD tiles and ROI without ConfigSvc, with computePrimitives
     bool                                m_printtables;
     bool                                m_firstevent;
     double                              m_firstTriggerTime;
-    unsigned                            m_mootKey;
+    unsigned long long                  m_firstTriggerTick;
+    unsigned                            m_mootKey;      //! of the configuration that the prescale counters follow
+    const Configuration*                m_sequenced;    //! that configuration, 0 before the first event
+    bool                                m_mootKeyRestored; //! m_mootKey is that of the previous job, from StateInput
+
+    /// configurations by MOOT key and TrgConfig, kept to the end: an event may still use one
+    typedef std::map<std::pair<unsigned, const TrgConfig*>, const Configuration*> ConfigurationMap;
+    ConfigurationMap                    m_configurations;
+    Trigger::Mutex                      m_configurationLock; //! for the lookup and insertion in m_configurations
     
     std::map<unsigned int, enums::Lsf::LeakedPrescaler> m_dgnMap;
+
+    std::set<int>                       m_fmxWarned;    //! 1000*mode+handler of the FMX key mismatches reported
+    Trigger::Mutex                      m_fmxWarnedLock;
+    bool                                m_finalized;    //! the summary was made
+
+    // TDS locations used for each event
+    Trigger::TdsHandle<Event::DigiEvent>    m_digiEvent;
+    Trigger::TdsHandle<Event::TriggerInfo>  m_triggerInfo;
+    Trigger::TdsHandle<Event::EventHeader>  m_header;
+    Trigger::TdsHandle<LdfEvent::Gem>       m_gem;
+    Trigger::TdsHandle<LsfEvent::MetaEvent> m_metaEvent;
+    Trigger::TdsHandle<Event::AcdDigiCol>   m_acdDigis;   //! with computePrimitives
+    Trigger::TdsHandle<Trigger::PrimitiveStatus> m_primitiveStatus; //! from TriggerInfoAlg with lazyPrimitives
 };
 
 //------------------------------------------------------------------------------
@@ -138,9 +306,10 @@ DECLARE_ALGORITHM_FACTORY(TriggerAlg);
 /// 
 TriggerAlg::TriggerAlg(const std::string& name, ISvcLocator* pSvcLocator) 
 : Algorithm(name, pSvcLocator), m_event(0)
-, m_lastTriggerTime(0)
-, m_lastWindowTime(0)
+, m_lastTriggerTick(0)
+, m_lastWindowTick(0)
 , m_total(0)
+, m_lookups(0)
 , m_triggered(0)
 , m_deadtime_reject(0)
 , m_window_reject(0)
@@ -150,22 +319,44 @@ TriggerAlg::TriggerAlg(const std::string& name, ISvcLocator* pSvcLocator)
 , m_triggerTables(0)
 , m_configSvc(0)
 , m_pcounter(0)
+, m_calTrigTool(0)
+, m_acdTiles(0)
 , m_firstevent(true)
 , m_firstTriggerTime(0)
+, m_firstTriggerTick(0)
 , m_mootKey(0)
+, m_sequenced(0)
+, m_mootKeyRestored(false)
+, m_finalized(false)
+, m_digiEvent(EventModel::Digi::Event)
+, m_triggerInfo("/Event/TriggerInfo")
+, m_header(EventModel::EventHeader)
+, m_gem("/Event/Gem")
+, m_metaEvent("/Event/MetaEvent")
+, m_acdDigis(EventModel::Digi::AcdDigiCol)
+, m_primitiveStatus(Trigger::PrimitiveStatus::path())
 {
     declareProperty("mask"    ,              m_maskProperty="0xffffffff");   // trigger mask
     declareProperty("throttle",              m_throttle=false);              // if set, veto when throttle bit is on
     declareProperty("vetomask",              m_vetomask=1+2+4);              // if thottle it set, veto if trigger masked with these ...
     declareProperty("vetobits",              m_vetobits=1+2);                // equals these bits
 
-    declareProperty("engine",                m_table = "ConfigSvc");         // set to "default"  to use default engine table
+    declareProperty("engine",                m_table = "ConfigSvc");         // set to "default"  to use default engine table, or a table file name
     declareProperty("prescale",              m_prescale=std::vector<int>()); // vector of prescale factors
     declareProperty("applyPrescales",        m_applyPrescales=false);        // if using ConfigSvc, do we want to prescale events
     declareProperty("useGltWordForData",     m_useGltWordForData=false);     // even if a GEM word exists use the Glt word
     declareProperty("applyWindowMask",       m_applyWindowMask=false);       // Do we want to use a window open mask?
     declareProperty("applyDeadtime",         m_applyDeadtime=false);         // Do we want to apply deadtime?
     declareProperty("failOnFmxKeyMismatch",  m_failOnFmxKeyMismatch=true);   // Do we want to fail if the FMX key doesn't match?
+    declareProperty("prescaleSeek",          m_prescaleSeek=std::vector<int>()); // starting count of events for each engine
+    declareProperty("summaryFile",           m_summaryFile="");              // file to write the bit pattern counts to, as "stage,value,count"
+    declareProperty("summaryReference",      m_summaryReference="");         // summaryFile of another job: fail unless the triggered counts are the same
+    declareProperty("computePrimitives",     m_computePrimitives=false);     // compute the trigger primitives here, instead of TriggerInfoAlg
+    declareProperty("registerTriggerInfo",   m_registerTriggerInfo=false);   // with computePrimitives, register TriggerInfo also for rejected events
+    declareProperty("TowersToTurnOn",        m_towersOnProperty="0x000");    // with computePrimitives, turn "on" these towers...
+    declareProperty("BilayersToTurnOn",      m_bilayersOnProperty="0x000");  // ... and these bilayers in them
+    declareProperty("StateInput",            m_stateInput="");               // state file of a previous job to continue from
+    declareProperty("StateOutput",           m_stateOutput="");              // state file to write at finalize
 
     return;
 }
@@ -193,6 +384,25 @@ StatusCode TriggerAlg::initialize()
     }
     log << endreq;
 
+    // the starting counts are ordinals: larger ones than an int can hold come from a state file
+    const std::vector<int>& seek = m_prescaleSeek.value();
+    for (unsigned int i=0; i<seek.size(); ++i)
+    {
+        if (seek[i] < 0)
+        {
+            log << MSG::ERROR << "prescaleSeek for engine " << i << " is negative: " << seek[i] << endreq;
+            return StatusCode::FAILURE;
+        }
+    }
+
+    // otherwise only for the calorimeter primitives that a lazy TriggerInfoAlg skips, when found
+    if (m_computePrimitives)
+    {
+        sc = retrieveCalTrigTool(log);
+        if (sc.isFailure()) return sc;
+        log << MSG::INFO << "Computing the trigger primitives, no TriggerInfoAlg needed" << endreq;
+    }
+
     sc = service("LivetimeSvc", m_LivetimeSvc);
     if( sc.isFailure() ) {
         log << MSG::ERROR << "failed to get the LivetimeSvc" << endreq;
@@ -214,15 +424,27 @@ StatusCode TriggerAlg::initialize()
 
             m_pcounter    = new EnginePrescaleCounter(m_prescale.value());
             m_printtables = true;
+
+            // start the counters where a previous part of the job left them
+            for (unsigned int i=0; i<seek.size(); ++i) m_pcounter->seek(i, seek[i]);
         }else{
             // selected trigger tables and engines for event selection
-            m_triggerTables = new Trigger::TriggerTables(m_table.value(), m_prescale.value());
+            try {
+                m_triggerTables = new Trigger::TriggerTables(m_table.value(), m_prescale.value());
+            }catch(const std::exception& e){
+                log << MSG::ERROR << "failed to set up trigger tables: " << e.what() << endreq;
+                return StatusCode::FAILURE;
+            }
 
             log << MSG::INFO << "Trigger tables: \n";
             m_triggerTables->print(log.stream());
             log << endreq;
+
+            m_triggerTables->seek(std::vector<unsigned long long>(seek.begin(), seek.end()));
         }
     }
+
+    if (m_computePrimitives && !m_pcounter) m_acdTiles = new Trigger::AcdTileTable; // otherwise in each Configuration
     
     // Initialize the map for outputting the bit names
     for( int i=0; i<8; ++i) 
@@ -253,6 +475,35 @@ StatusCode TriggerAlg::initialize()
     m_dgnMap[10] = enums::Lsf::COND20;
     m_dgnMap[11] = enums::Lsf::COND19;    
 
+    m_digiEvent.initialize(eventSvc());
+    m_triggerInfo.initialize(eventSvc());
+    m_header.initialize(eventSvc());
+    m_gem.initialize(eventSvc());
+    m_metaEvent.initialize(eventSvc());
+    m_acdDigis.initialize(eventSvc());
+    m_primitiveStatus.initialize(eventSvc());
+
+    if (!m_stateInput.value().empty())
+    {
+        std::string filename(m_stateInput.value());
+        facilities::Util::expandEnvVar(&filename);
+        Trigger::StateFile state(name() + ".");
+        if (!state.read(filename))
+        {
+            log << MSG::ERROR << "could not read the state file " << filename << endreq;
+            return StatusCode::FAILURE;
+        }
+        restoreState(state);
+        if (!state.missing().empty())
+        {
+            log << MSG::ERROR << "the state file " << filename << " has no";
+            for (unsigned int i=0; i<state.missing().size(); ++i) log << ' ' << state.missing()[i];
+            log << endreq;
+            return StatusCode::FAILURE;
+        }
+        log << MSG::INFO << "Continuing from the state in " << filename << endreq;
+    }
+
     return sc;
 }
 
@@ -266,124 +517,293 @@ StatusCode TriggerAlg::execute()
     StatusCode  sc = StatusCode::SUCCESS;
     MsgStream   log( msgSvc(), name() );
 
-    // GET the MOOT key and check to see if the configuration has changed
-    bool             configChanged = false;
-    const TrgConfig* tcf(0);
+    Classification event;
+    sc = configure(event, log);
+    if (sc.isFailure()) return sc;
+
+    sc = classify(event, log);
+    if (sc.isFailure()) return sc;
+
+    Sequence sequenced;
+    bool triggered = sequence(event, sequenced, log);
+
+    sc = fill(event, sequenced, triggered, log);
+    if (!triggered) setFilterPassed(false);
+    return sc;
+}
+
+//------------------------------------------------------------------------------
+TriggerAlg::Configuration::Configuration(unsigned key, const TrgConfig& config, const std::vector<int>& prescales,
+                                         bool withAcdTiles)
+: mootKey(key)
+, tcf(&config)
+, engines(prescales)
+, windowMask(config.windowParams() ? config.windowParams()->windowMask() : 0)
+, acdTiles(withAcdTiles ? new Trigger::AcdTileTable(*config.roi()) : 0)
+{
+    // flatten the engine lookup once per configuration
+    engineTable.set(&config);
+    engines.configure(engineTable);
+}
+
+//------------------------------------------------------------------------------
+StatusCode TriggerAlg::retrieveCalTrigTool(MsgStream& log)
+{
+    if (m_calTrigTool != 0) return StatusCode::SUCCESS;
 
-    if (m_pcounter)     // non-zero means ConfigSvc is being used
+    ICalTrigTool* calTrigTool(0);
+    StatusCode sc = toolSvc()->retrieveTool("CalTrigTool", "CalTrigTool", calTrigTool, 0); /// could be shared
+    if (sc.isFailure() ) 
     {
-        unsigned mKey = m_configSvc->getMootKey();
-        tcf           = m_configSvc->getTrgConfig();
+        log << MSG::ERROR << "  Unable to create CalTrigTool" << endreq;
+        return sc;
+    }
+    m_primitives.initialize(calTrigTool,
+                            facilities::Util::stringToUnsigned(m_towersOnProperty),
+                            facilities::Util::stringToUnsigned(m_bilayersOnProperty));
+    m_calTrigTool = calTrigTool;
+    return sc;
+}
 
-        // Successful at recovering Trigger Configuration?
-        if ( tcf == 0 ) 
-        {
-            log << MSG::ERROR << "Failed to get trigger config from ConfigSvc." << endreq;
-            return StatusCode::FAILURE;
-        }
+//------------------------------------------------------------------------------
+StatusCode TriggerAlg::configure(Classification& event, MsgStream& log)
+{
+    event.config  = 0;
+    event.lookups = 0;
 
-        configChanged = mKey != m_mootKey;
-        m_mootKey     = mKey;
+    // skipped calorimeter primitives may have to be computed: the first ones need the CalTrigTool
+    event.primitiveStatus = m_computePrimitives ? 0 : m_primitiveStatus.find(event.lookups);
+    if (event.primitiveStatus != 0 && !event.primitiveStatus->computed(Trigger::PrimitiveStatus::CAL))
+    {
+        Trigger::Mutex::Lock lock(m_configurationLock);
+        StatusCode sc = retrieveCalTrigTool(log);
+        if (sc.isFailure()) return sc;
     }
 
-    // Is this Monte Carlo?
-    SmartDataPtr<Event::DigiEvent> de(eventSvc(),   EventModel::Digi::Event);
-    if( de==0 ) log << MSG::DEBUG << "No digi event found" << endreq;
+    if (m_pcounter==0) return StatusCode::SUCCESS; // non-zero means ConfigSvc is being used
 
-    bool isMc = de ? de->fromMc() : false;
-    
-    // Start by recovering the trigger primitives from the TriggerInfo object which
-    // we can find in the TDS (created by TriggerInfoAlg)
-    SmartDataPtr<Event::TriggerInfo> triggerInfo(eventSvc(), "/Event/TriggerInfo");
-    if( triggerInfo == 0) 
+    // GET the MOOT key and the configuration: a new pair makes new tables
+    const TrgConfig* tcf = m_configSvc->getTrgConfig();
+
+    // Successful at recovering Trigger Configuration?
+    if ( tcf == 0 ) 
     {
-        log << MSG::ERROR << "No TriggerInfo found" << endreq;
+        log << MSG::ERROR << "Failed to get trigger config from ConfigSvc." << endreq;
         return StatusCode::FAILURE;
     }
 
-    // set bits in the trigger word
-    unsigned short tkrvector    = triggerInfo->getTkrVector();
-    unsigned short cnovector    = triggerInfo->getCnoVector();
-    unsigned short roivector    = triggerInfo->getRoiVector();
-    unsigned short callovector  = triggerInfo->getCalLeVector();
-    unsigned short calhivector  = triggerInfo->getCalHeVector();
-    unsigned int   trigger_bits = triggerInfo->getTriggerBits();
-
-    // List of struck tiles
-    const Event::TriggerInfo::TileList& tilelist = triggerInfo->getTileList();
+    std::pair<unsigned, const TrgConfig*> key(m_configSvc->getMootKey(), tcf);
 
-    // Accumulate some status
-    m_total++;
-    m_counts[trigger_bits] +=1;
+    // another event may be inserting a configuration: the map must not be read meanwhile
+    Trigger::Mutex::Lock lock(m_configurationLock);
+    ConfigurationMap::const_iterator it = m_configurations.find(key);
+    if (it != m_configurations.end())
+    {
+        event.config = it->second;
+        return StatusCode::SUCCESS;
+    }
 
-    // Apply window mask. Only proceed if the window was opened 
-    // or any trigger bit was set if window open mask was not available.
-    if (m_applyWindowMask)
+    if (m_computePrimitives && tcf->roi() == 0) 
     {
-        unsigned windowOpen=0;
+        log << MSG::ERROR << "Failed to get ROI mapping from MOOT" << endreq;
+        return StatusCode::FAILURE;
+    } 
+
+    event.config = m_configurations[key] = new Configuration(key.first, *tcf, m_prescale.value(), m_computePrimitives);
+    return StatusCode::SUCCESS;
+}
+
+//------------------------------------------------------------------------------
+StatusCode TriggerAlg::classify(Classification& event, MsgStream& log) const
+{
+    StatusCode sc = StatusCode::SUCCESS;
+
+    // Is this Monte Carlo?
+    Event::DigiEvent* de = m_digiEvent.find(event.lookups);
+    if( de==0 ) log << MSG::DEBUG << "No digi event found" << endreq;
+
+    event.isMc = de ? de->fromMc() : false;
 
-        if (m_pcounter) // using ConfigSvc
+    // Retrieve the EventHeader from the TDS (which, by definition of the TDS, must exist)
+    event.header = m_header.find(event.lookups);
+
+    // Retrieve GEM from the TDS
+    event.gem = m_gem.find(event.lookups);
+    if( event.gem==0 ) log << MSG::DEBUG << "No GEM found" << endreq;
+    
+    // Start with the trigger primitives: computed here, or recovered from the TriggerInfo
+    // object which we can find in the TDS (created by TriggerInfoAlg)
+    Trigger::TriggerPrimitives::Values& primitives = event.primitives;
+    event.triggerInfo      = 0;
+    event.calorimeterAdded = false;
+    if (m_computePrimitives)
+    {
+        const Trigger::AcdTileTable& acdTiles = event.config ? *event.config->acdTiles : *m_acdTiles;
+        m_primitives.compute(acdTiles, TriRowBitsTds::TkrLayerBits::get(eventSvc(), event.lookups),
+                             m_acdDigis.find(event.lookups), log, primitives);
+        if (m_primitives.computeCalorimeter(primitives).isFailure())
+            return StatusCode::FAILURE;
+    }
+    else
+    {
+        Event::TriggerInfo* triggerInfo = m_triggerInfo.find(event.lookups);
+        if( triggerInfo == 0) 
         {
-            windowOpen = trigger_bits & tcf->windowParams()->windowMask();
-        }else{
-            windowOpen = trigger_bits & m_mask;
+            log << MSG::ERROR << "No TriggerInfo found" << endreq;
+            return StatusCode::FAILURE;
         }
-      
-        if ( !windowOpen)
+        primitives.triggerBits         = triggerInfo->getTriggerBits();
+        primitives.tkrVector           = triggerInfo->getTkrVector();
+        primitives.roiVector           = triggerInfo->getRoiVector();
+        primitives.calLoVector         = triggerInfo->getCalLeVector();
+        primitives.calHiVector         = triggerInfo->getCalHeVector();
+        primitives.cnoVector           = triggerInfo->getCnoVector();
+        primitives.deltaEventTime      = triggerInfo->getDeltaEventTime();
+        primitives.deltaWindowOpenTime = triggerInfo->getDeltaWindowOpenTime();
+        primitives.vetoTiles.fromTileList(triggerInfo->getTileList());
+        event.triggerInfo = triggerInfo;
+
+        // TriggerInfoAlg skips them when its own engines reject the event, which may not be ours
+        if (event.primitiveStatus != 0 && !event.primitiveStatus->computed(Trigger::PrimitiveStatus::CAL)
+            && calorimeterNeeded(event, primitives.triggerBits))
         {
-            m_window_reject++;
-            setFilterPassed(false);
-            return sc;
+            if (m_primitives.computeCalorimeter(primitives).isFailure())
+                return StatusCode::FAILURE;
+            event.calorimeterAdded = true;
         }
     }
-    m_window_counts[trigger_bits] +=1;
-  
-    // Retrieve the EventHeader from the TDS (which, by definition of the TDS, must exist)
-    SmartDataPtr<Event::EventHeader> header(eventSvc(), EventModel::EventHeader);
+    unsigned int trigger_bits = primitives.triggerBits;
 
-    // record window open time
-    double         now = header->time();
-    unsigned short deltawotime = triggerInfo->getDeltaWindowOpenTime();
+    // Window mask: only proceed if the window was opened, 
+    // or any trigger bit was set if window open mask was not available.
+    event.windowOpen = !m_applyWindowMask || (trigger_bits & windowMask(event)) != 0;
+
+    // IF Gem is present (data?) then we use it to determine the trigger, otherwise, use the calculated trigger_bits
+    event.gltword = Trigger::TriggerPrimitives::gemConditions(trigger_bits);
+    event.gemword = event.gem ? event.gem->conditionSummary() : event.gltword;
 
-    // Overlay events will set deltawotime if using them, otherwise get from livetime service
-    if(deltawotime == 0xffff && m_lastWindowTime != 0)
+    // GEM information 
+    event.gemengine    = 16; // default engine number
+    event.gltengine    = 16;
+    event.gemprescale  = 0;
+    event.gltprescale  = 0;
+    event.longdeadtime = false;
+    event.prescaleword = event.gltword;
+    event.throttled    = false;
+
+    if (!event.isMc && !m_useGltWordForData) //this is data and we want to use the GEM summary word
     {
-        deltawotime = m_LivetimeSvc->ticks(now-m_lastWindowTime) < 0xffff 
-                    ? m_LivetimeSvc->ticks(now-m_lastWindowTime)
-                    : 0xffff;
+        event.prescaleword = event.gemword;
     }
-    m_lastWindowTime = now;
 
-    // Retrieve GEM from the TDS
-    SmartDataPtr<LdfEvent::Gem> gem(eventSvc(), "/Event/Gem"); 
-    if( gem==0 ) log << MSG::DEBUG << "No GEM found" << endreq;
+    if( m_triggerTables!=0 )
+    {
+        // the engine is selected, and prescaled, in sequence
+    } else if (m_pcounter!=0){        
+        assert(event.isMc || m_useGltWordForData || event.gem!=0);
 
-    // GEM information 
-    int          engine(16); // default engine number
-    int          gemengine(16);
-    int          gltengine(16);
+        // Retrieve the engine numbers for both the GEM and GLT
+        const Trigger::ConfigEngineTable::Entry& gemEntry = event.config->engineTable[event.gemword];
+        event.gemengine   = gemEntry.engine;
+        event.gemprescale = gemEntry.prescale;
+        const Trigger::ConfigEngineTable::Entry& gltEntry = event.config->engineTable[event.gltword];
+        event.gltengine    = gltEntry.engine;
+        event.gltprescale  = gltEntry.prescale;
+        event.longdeadtime = gltEntry.fourRange;
+    }else {
+        // throttle filter, if requested
+        event.throttled = m_throttle && ( (trigger_bits & m_vetomask) == (unsigned)m_vetobits );
+    }
+    return sc;
+}
 
-    // IF Gem is present (data?) then we use it to determine the trigger, otherwise, use the calculated trigger_bits
-    unsigned int gemword = gem ? gem->conditionSummary() : gemBits(trigger_bits);
+//------------------------------------------------------------------------------
+unsigned int TriggerAlg::windowMask(const Classification& event) const
+{
+    return event.config ? event.config->windowMask : m_mask; // from ConfigSvc, or the trigger mask
+}
+
+//------------------------------------------------------------------------------
+bool TriggerAlg::calorimeterNeeded(const Classification& event, unsigned int trigger_bits) const
+{
+    // with a GEM the engine does not depend on the primitives (TriggerInfoAlg does not skip them then)
+    if (event.gem != 0) return true;
+
+    // a window that no calorimeter bit can open stays closed
+    if (m_applyWindowMask && (trigger_bits & windowMask(event)) == 0)
+    {
+        return (windowMask(event) & (enums::b_LO_CAL | enums::b_HI_CAL)) != 0;
+    }
+
+    int known   = Trigger::TriggerPrimitives::gemConditions(trigger_bits);
+    int unknown = LdfEvent::Gem::CALLE | LdfEvent::Gem::CALHE;
+
+    if (m_triggerTables)                 return m_triggerTables->canPass(known, unknown);
+    if (event.config && m_applyPrescales) return event.config->engines.canPass(known, unknown);
+    return true; // not rejected by engines: the bits themselves are in the trigger word
+}
+
+//------------------------------------------------------------------------------
+bool TriggerAlg::sequence(const Classification& event, Sequence& sequenced, MsgStream& log)
+{
+    unsigned int trigger_bits = event.primitives.triggerBits;
+    Event::EventHeader* header = event.header;
+
+    // the prescale counters follow the configurations in event order; they are reset when
+    // an event that reaches them has a new MOOT key, also one other than that of a restored state
+    bool keyChanged = false;
+    if (event.config != 0 && event.config != m_sequenced)
+    {
+        keyChanged  = (m_sequenced != 0 || m_mootKeyRestored) && event.config->mootKey != m_mootKey;
+        m_pcounter->configure(event.config->engineTable);
+        m_sequenced = event.config;
+        m_mootKey   = event.config->mootKey;
+    }
+
+    // Accumulate some status
+    m_total++;
+    m_lookups += event.lookups;
+    m_counts.fill(trigger_bits);
+
+    // Apply window mask
+    if (!event.windowOpen)
+    {
+        m_window_reject++;
+        return false;
+    }
+    m_window_counts.fill(trigger_bits);
+  
+    // record window open time, on the GEM clock
+    double             now      = header->time();
+    unsigned long long nowTicks = m_LivetimeSvc->ticks(now);
+    unsigned short     deltawotime = event.primitives.deltaWindowOpenTime;
+
+    // Overlay events will set deltawotime if using them, otherwise from the clock
+    if(deltawotime == 0xffff && m_lastWindowTick != 0)
+    {
+        deltawotime = deltaTicks(nowTicks, m_lastWindowTick);
+    }
+    m_lastWindowTick = nowTicks;
 
     // apply filter for subsequent processing.
     if( m_triggerTables!=0 )
     {
-        engine = (*m_triggerTables)(trigger_bits & 0x001F); // note only apply to low 5 bits for now
+        // use the full condition summary, so that external, solicited and periodic
+        // conditions in a real GEM select their engines as in flight, unless useGltWordForData
+        int engine = (*m_triggerTables)(event.prescaleword);
         log << MSG::DEBUG << "Engine is " << engine << endreq;
 
         if( engine<=0 ) 
         {
-            setFilterPassed(false);
             m_prescaled++;
             log << MSG::DEBUG << "Event did not trigger, according to engine selected by trigger table" << endreq;
-            return sc;
+            return false;
         }
     } else if (m_pcounter!=0){        
-        if(!m_printtables && configChanged )
+        if (keyChanged)
         {
             log<<MSG::INFO<<"Trigger configuration changed.";
-            if ( tcf != 0 ) tcf->printContrigurator(log.stream());
+            event.config->tcf->printContrigurator(log.stream());
             log<<endreq;
             m_pcounter->reset();
         }
@@ -391,7 +811,7 @@ StatusCode TriggerAlg::execute()
         if (m_printtables)
         {
             log << MSG::INFO << "Trigger tables: \n";
-            if ( tcf != 0 ) tcf->printContrigurator(log.stream());
+            event.config->tcf->printContrigurator(log.stream());
             log<<endreq;
             m_printtables=false;
             if(! m_applyPrescales ) 
@@ -403,87 +823,114 @@ StatusCode TriggerAlg::execute()
             }
         }
     
-        bool passed = true;
-        if (isMc || m_useGltWordForData)   // this is either MC or user wants glt word used for prescaling
-        {
-            passed = m_pcounter->decrementAndCheck(gemBits(trigger_bits),tcf);
-        } else {                           //this is data and we want to use the GEM summary word
-            assert(gem!=0);
-            passed = m_pcounter->decrementAndCheck(gem->conditionSummary(),tcf); 
-        }
+        bool passed = m_pcounter->decrementAndCheck(event.prescaleword);
     
         header->setPrescaleExpired(passed);
         
         // Check prescales
         if(!passed && m_applyPrescales)
         {
-            setFilterPassed(false);
             m_prescaled++;
             log << MSG::DEBUG << "Event did not trigger, according to engine selected by ConfigSvc" << endreq;
-            return sc;
+            return false;
         }
 
-        // Retrieve the engine numbers for both the GEM and GLT
-        gemengine = tcf->lut()->engineNumber(gemword);
-        header->setGemPrescale(tcf->trgEngine()->prescale(gemengine));
-        gltengine = tcf->lut()->engineNumber(gemBits(trigger_bits));
-        header->setGltPrescale(tcf->trgEngine()->prescale(gltengine));
-    }else {
-        // apply throttle filter if requested
-        if( m_throttle && ( (trigger_bits & m_vetomask) == (unsigned)m_vetobits ) ) 
-        {
-            setFilterPassed( false );
-            m_prescaled++;
-            log << MSG::DEBUG << "Event did not trigger" << endreq;
-            return sc;
-        }
+        header->setGemPrescale(event.gemprescale);
+        header->setGltPrescale(event.gltprescale);
+    }else if( event.throttled ) {
+        m_prescaled++;
+        log << MSG::DEBUG << "Event did not trigger" << endreq;
+        return false;
     }
 
     // passed trigger: continue processing
-    m_prescaled_counts[trigger_bits] +=1;
+    m_prescaled_counts.fill(trigger_bits);
 
     // check for deadtime: set flag only if applying deadtime
+    double livetime = 0; // accumulated by the LivetimeSvc
     if(m_applyDeadtime)
     {
-        enums::GemState gemstate=m_LivetimeSvc->checkState(now);
+        // state, live, and registered if live, in one call; longdeadtime is only set when using ConfigSvc
+        enums::GemState gemstate;
+        bool            live;
+        m_LivetimeSvc->registerEvents(&now, &event.longdeadtime, 1, &gemstate, &live, &livetime);
         if (gemstate==enums::DEADZONE)m_deadzone++;
         else if (gemstate==enums::BUSY)m_busy++;
-        if( !m_LivetimeSvc->isLive(now)) 
+        if( !live ) 
         { 
             m_deadtime_reject ++;
-            setFilterPassed(false);
-            return sc;
+            return false;
         }
-        bool longdeadtime=false;
-        if(m_pcounter!=0 && gltengine!=-1) // using ConfigSvc
-            longdeadtime= tcf->trgEngine()->fourRangeReadout(gltengine);
-        m_LivetimeSvc->tryToRegisterEvent(now,longdeadtime);
     } 
     
     m_triggered++;
-    m_trig_counts[trigger_bits] +=1;
+    m_trig_counts.fill(trigger_bits);
 
-    unsigned short deltaevtime = triggerInfo->getDeltaEventTime();
+    unsigned short deltaevtime = event.primitives.deltaEventTime;
 
-    // If using overlays then deltaevtime is supplied, otherwise use livetime service to determine
-    if(deltaevtime == 0xffff && m_lastTriggerTime !=0 )
+    // If using overlays then deltaevtime is supplied, otherwise from the clock
+    if(deltaevtime == 0xffff && m_lastTriggerTick !=0 )
     {
-        deltaevtime = m_LivetimeSvc->ticks(now-m_lastTriggerTime)<0xffff 
-                    ? m_LivetimeSvc->ticks(now-m_lastTriggerTime) 
-                    : 0xffff;
+        deltaevtime = deltaTicks(nowTicks, m_lastTriggerTick);
     }
 
-    m_lastTriggerTime=now;
+    m_lastTriggerTick=nowTicks;
     if(m_firstevent)
     {
         m_firstTriggerTime = now;
+        m_firstTriggerTick = nowTicks;
         m_firstevent       = false;
     }
-    
-    if (m_applyDeadtime) 
-        header->setLivetime(m_LivetimeSvc->livetime());
-    else
-        header->setLivetime(header->time()-m_firstTriggerTime);
+
+    // the clock counts, with livetime and elapsed time since the first trigger if not applying deadtime
+    LivetimeTicks& ticks = sequenced.ticks;
+    m_LivetimeSvc->tickSnapshot(now, ticks);
+    if (!m_applyDeadtime)
+    {
+        ticks.livetime = ticks.elapsed = ticks.time-m_firstTriggerTick;
+    }
+
+    // what the objects of the event need from the sequence so far
+    sequenced.now                 = now;
+    sequenced.deltaEventTime      = deltaevtime;
+    sequenced.deltaWindowOpenTime = deltawotime;
+    sequenced.livetime            = m_applyDeadtime ? livetime : now-m_firstTriggerTime;
+    sequenced.prescaled           = m_prescaled;
+    sequenced.busy                = m_busy;
+    sequenced.deadzone            = m_deadzone;
+    m_lookups++; // the MetaEvent, that fill looks up for an event that triggers
+    return true;
+}
+
+//------------------------------------------------------------------------------
+StatusCode TriggerAlg::fill(const Classification& event, const Sequence& sequenced, bool triggered, MsgStream& log)
+{
+    StatusCode sc = StatusCode::SUCCESS;
+
+    const Trigger::TriggerPrimitives::Values& primitives = event.primitives;
+
+    // computed here: the TriggerInfo is only made for events that pass, unless registerTriggerInfo
+    if (m_computePrimitives && (triggered || m_registerTriggerInfo))
+    {
+        sc = eventSvc()->registerObject(m_triggerInfo.path(), primitives.makeTriggerInfo());
+        if (sc.isFailure()) return sc;
+    }
+
+    // complete the TriggerInfo with the calorimeter primitives that TriggerInfoAlg skipped
+    if (event.calorimeterAdded)
+    {
+        primitives.fillTriggerInfo(*event.triggerInfo);
+        event.primitiveStatus->addComputed(Trigger::PrimitiveStatus::CAL);
+    }
+
+    if (!triggered) return sc;
+
+    unsigned int        trigger_bits = primitives.triggerBits;
+    Event::EventHeader* header       = event.header;
+    LdfEvent::Gem*      gem          = event.gem;
+    double              now          = sequenced.now;
+
+    header->setLivetime(sequenced.livetime);
 
     log << MSG::DEBUG 
         << "Processing run/event " << header->run() << "/" << header->event() << " trigger & mask = "
@@ -492,13 +939,13 @@ StatusCode TriggerAlg::execute()
 
 #if 0 // this is masked off and was never used
     // or in the gem trigger bits, either from hardware, or derived from trigger
-    trigger_bits |= gemBits(trigger_bits) << enums::GEM_offset;
+    trigger_bits |= Trigger::TriggerPrimitives::gemConditions(trigger_bits) << enums::GEM_offset;
     trigger_bits |= engine << (2*enums::GEM_offset); // also the engine number (if set)
 #endif
 
     // Set the Trigger Words
-    unsigned int triggerWordTwo = gltengine    | gemengine << enums::ENGINE_offset;
-    unsigned int triggerword    = trigger_bits | gemword   << enums::GEM_offset;
+    unsigned int triggerWordTwo = event.gltengine | event.gemengine << enums::ENGINE_offset;
+    unsigned int triggerword    = trigger_bits    | event.gemword   << enums::GEM_offset;
 
     if( static_cast<int>(header->trigger())==-1 
         || header->trigger()==0  // this seems to happen when reading back from incoming??
@@ -521,41 +968,36 @@ StatusCode TriggerAlg::execute()
     }
 
     // fill GEM structure for MC
-    if (isMc && gem == 0)
+    if (event.isMc && gem == 0)
     {
         //make vetotilelist object
         LdfEvent::GemTileList vetoTileList;
         vetoTileList.clear();
 
-        makeGemTileList(tilelist,vetoTileList);
+        makeGemTileList(primitives.vetoTiles,vetoTileList);
 
         LdfEvent::Gem *gemTds = new LdfEvent::Gem();
-        gemTds->initTrigger(tkrvector,roivector,
-                            callovector,calhivector,
-                            cnovector,gemword,
-                            m_deadzone&0xff,vetoTileList); 
+        gemTds->initTrigger(primitives.tkrVector,primitives.roiVector,
+                            primitives.calLoVector,primitives.calHiVector,
+                            primitives.cnoVector,event.gemword,
+                            sequenced.deadzone&0xff,vetoTileList); 
       
-        LdfEvent::GemOnePpsTime ppsTimeTds(m_LivetimeSvc->ticks((unsigned int)now) & 0x1ffffff, ((unsigned int) now) & 0x7f);
+        const LivetimeTicks& ticks = sequenced.ticks;
+        LdfEvent::GemOnePpsTime ppsTimeTds(ticks.onePps & 0x1ffffff, ((unsigned int) now) & 0x7f);
 
         LdfEvent::GemDataCondArrivalTime gemCondTimeTds;
         gemCondTimeTds.init(0);// no conditions arrival time in Monte Carlo
 
-        unsigned long long livetime=0;
-        if(m_applyDeadtime)
-            livetime = m_LivetimeSvc->ticks(m_LivetimeSvc->livetime());
-        else
-            livetime = m_LivetimeSvc->ticks(now-m_firstTriggerTime);
-
-        gemTds->initSummary(livetime & 0xffffff,
-                            m_prescaled & 0xffffff,
-                            m_busy & 0xffffff,
+        gemTds->initSummary(ticks.livetime & 0xffffff,
+                            sequenced.prescaled & 0xffffff,
+                            sequenced.busy & 0xffffff,
                             gemCondTimeTds,
-                            m_LivetimeSvc->ticks(now) & 0x1ffffff, 
+                            ticks.time & 0x1ffffff, 
                             ppsTimeTds, 
-                            deltaevtime,
-                            deltawotime);
+                            sequenced.deltaEventTime,
+                            sequenced.deltaWindowOpenTime);
       
-        sc = eventSvc()->registerObject("/Event/Gem", gemTds);
+        sc = eventSvc()->registerObject(m_gem.path(), gemTds);
         if( sc.isFailure() ) 
         {
             log << MSG::ERROR << "could not register /Event/Gem " << endreq;
@@ -566,20 +1008,20 @@ StatusCode TriggerAlg::execute()
         gem = gemTds;
     }
 
-    // Recover MetaEvent from TDS
-    SmartDataPtr<LsfEvent::MetaEvent> metaTds(eventSvc(), "/Event/MetaEvent");
+    // Recover MetaEvent from TDS: counted by sequence
+    LsfEvent::MetaEvent* metaTds = m_metaEvent.find();
     if( metaTds==0) log<< MSG::DEBUG <<"No Meta event found."<<endreq;
 
     LsfEvent::MetaEvent* meta = metaTds;
 
     // Fill MetaEvent for MC
-    if (isMc && !metaTds)
+    if (event.isMc && !metaTds)
     {
         // Meta event GEM scalers     
         if (meta == 0)
         {
             meta=new LsfEvent::MetaEvent;
-            sc = eventSvc()->registerObject("/Event/MetaEvent", meta);
+            sc = eventSvc()->registerObject(m_metaEvent.path(), meta);
             if (sc.isFailure()) 
             {
                 log << MSG::INFO << "Failed to register MetaEvent" << endreq;
@@ -587,22 +1029,16 @@ StatusCode TriggerAlg::execute()
             }
         }
 
-        unsigned long long elapsed = 0;
-        if(m_applyDeadtime)
-            elapsed=m_LivetimeSvc->ticks(m_LivetimeSvc->elapsed());
-        else
-            elapsed=m_LivetimeSvc->ticks(now-m_firstTriggerTime);
-
-        lsfData::GemScalers gs(elapsed,
+        lsfData::GemScalers gs(sequenced.ticks.elapsed,
                                gem->liveTime(),
-                               m_prescaled, 
-                               m_busy,
+                               sequenced.prescaled, 
+                               sequenced.busy,
                                header->event(),
-                               m_deadzone);
+                               sequenced.deadzone);
         meta->setScalers(gs);
     }
 
-    sc = handleMetaEvent(*meta, gemengine);    
+    sc = handleMetaEvent(*meta, event.gemengine, event.config);    
 
     return sc;
 }
@@ -612,9 +1048,8 @@ StatusCode TriggerAlg::finalize()
 {
     // purpose and method: make a summary
     StatusCode  sc = StatusCode::SUCCESS;
-    static bool first(true);
-    if( !first ) return sc;
-    first = false;
+    if( m_finalized ) return sc;
+    m_finalized = true;
 
     MsgStream log(msgSvc(), name());
     log << MSG::INFO << "Totals triggered/ processed: " << m_triggered << "/" << m_total ; 
@@ -640,56 +1075,155 @@ StatusCode TriggerAlg::finalize()
         {
             log << "\n\t\tRejected " << m_deadtime_reject << " events due to deadtime";
         }
+        if( m_total>0 )
+        {
+            log << "\n\t\tTDS lookups per event: " << double(m_lookups)/m_total;
+        }
     }
 
     log << endreq;
 
+    if (!m_summaryFile.value().empty())
+    {
+        std::string filename(m_summaryFile.value());
+        facilities::Util::expandEnvVar(&filename);
+        std::ofstream summary(filename.c_str());
+        summary << "stage,value,count\n";
+        m_counts.write(summary, "all");
+        m_window_counts.write(summary, "window");
+        m_prescaled_counts.write(summary, "prescaled");
+        m_trig_counts.write(summary, "triggered");
+        if (!summary)
+        {
+            log << MSG::ERROR << "could not write the summary file " << filename << endreq;
+            sc = StatusCode::FAILURE;
+        }
+    }
+
+    if (!m_summaryReference.value().empty())
+    {
+        // only the triggered events: the others may lack the calorimeter bits that did not matter
+        std::string filename(m_summaryReference.value());
+        facilities::Util::expandEnvVar(&filename);
+        std::ifstream reference(filename.c_str());
+        Trigger::TriggerBitHistogram expected;
+        if (!reference || !expected.read(reference, "triggered"))
+        {
+            log << MSG::ERROR << "could not read the summary file " << filename << endreq;
+            sc = StatusCode::FAILURE;
+        }
+        else if (!(m_trig_counts == expected))
+        {
+            log << MSG::ERROR << "the triggered counts differ from those of " << filename << ": "
+                << m_trig_counts.total() << " events, expected " << expected.total() << endreq;
+            sc = StatusCode::FAILURE;
+        }
+        else
+        {
+            log << MSG::INFO << "the triggered counts are those of " << filename << endreq;
+        }
+    }
+
+    if (!m_stateOutput.value().empty())
+    {
+        std::string filename(m_stateOutput.value());
+        facilities::Util::expandEnvVar(&filename);
+        Trigger::StateFile state(name() + ".");
+        saveState(state);
+        if (!state.write(filename))
+        {
+            log << MSG::ERROR << "could not write the state file " << filename << endreq;
+            sc = StatusCode::FAILURE;
+        }
+    }
+
+    delete m_acdTiles;
+    m_acdTiles = 0;
+    for (ConfigurationMap::iterator it = m_configurations.begin(); it != m_configurations.end(); ++it)
+    {
+        delete it->second;
+    }
+    m_configurations.clear();
+    m_sequenced = 0;
+
     //TODO: format this nicely, as a 4x4 table
 
     return sc;
 }
 
 //------------------------------------------------------------------------------
-unsigned int TriggerAlg::gemBits(unsigned int  trigger_bits)
-{
-    // set corresponding gem bits from glt word, should be a 1 to 1 translation
-
-    return 
-        ((trigger_bits & enums::b_ROI)    !=0 ? LdfEvent::Gem::ROI   : 0)
-        |((trigger_bits & enums::b_Track) !=0 ? LdfEvent::Gem::TKR   : 0)
-        |((trigger_bits & enums::b_LO_CAL)!=0 ? LdfEvent::Gem::CALLE : 0)
-        |((trigger_bits & enums::b_HI_CAL)!=0 ? LdfEvent::Gem::CALHE : 0)
-        |((trigger_bits & enums::b_ACDH)  !=0 ? LdfEvent::Gem::CNO   : 0) ;
-
+namespace {
+    std::string ordinalKey(unsigned int engine)
+    {
+        std::ostringstream key;
+        key << "ordinal." << engine;
+        return key.str();
+    }
 }
 
-//------------------------------------------------------------------------------
-void TriggerAlg::makeGemTileList(const Event::TriggerInfo::TileList& tileList, LdfEvent::GemTileList& vetotilelist)
+void TriggerAlg::saveState(Trigger::StateFile& state)const
 {
-    MsgStream log(msgSvc(), name());
-    vetotilelist.clear();
-
-    // If the tile list is empty this is a problem...
-    if (!tileList.empty())
+    if (m_triggerTables)
+    {
+        for (unsigned int i=0; i<m_triggerTables->size(); ++i) state.set(ordinalKey(i), (*m_triggerTables)[i].ordinal());
+    }
+    else if (m_pcounter)
     {
-        // By definition, the map quantities must be there...
-        unsigned short xzm = tileList.find("xzm")->second;
-        unsigned short xzp = tileList.find("xzp")->second;
-        unsigned short yzm = tileList.find("yzm")->second;
-        unsigned short yzp = tileList.find("yzp")->second;
-        unsigned int   xy  = tileList.find("xy")->second;
-        unsigned short rbn = tileList.find("rbn")->second;
-        unsigned short na  = tileList.find("na")->second;
+        // the counters belong to the configuration of this key: the next job resets them if it starts with another
+        state.set("mootKey", m_mootKey);
+        state.set("engines", m_pcounter->engines());
+        for (unsigned int i=0; i<m_pcounter->engines(); ++i) state.set(ordinalKey(i), m_pcounter->ordinal(i));
+    }
+    state.set("firstevent",       m_firstevent);
+    state.set("firstTriggerTime", m_firstTriggerTime);
+    state.set("firstTriggerTick", m_firstTriggerTick);
+    state.set("lastTriggerTick",  m_lastTriggerTick);
+    state.set("lastWindowTick",   m_lastWindowTick);
+    state.set("prescaled",        m_prescaled);
+    state.set("busy",             m_busy);
+    state.set("deadzone",         m_deadzone);
+}
 
-        vetotilelist.init(xzm,xzp,yzm,yzp,xy,rbn,na);
+void TriggerAlg::restoreState(Trigger::StateFile& state)
+{
+    // the prescale counters of the engines that the previous job saved
+    if (m_triggerTables)
+    {
+        std::vector<unsigned long long> ordinals(m_triggerTables->size());
+        for (unsigned int i=0; i<ordinals.size(); ++i) state.require(ordinalKey(i), ordinals[i]);
+        m_triggerTables->seek(ordinals);
     }
-    else
-        vetotilelist.init(0,0,0,0,0,0,0);
+    else if (m_pcounter)
+    {
+        unsigned int engines(0);
+        state.require("mootKey", m_mootKey);
+        state.require("engines", engines);
+        for (unsigned int i=0; i<engines; ++i)
+        {
+            unsigned long long ordinal(0);
+            state.require(ordinalKey(i), ordinal);
+            m_pcounter->seek(i, ordinal);
+        }
+        m_mootKeyRestored = true;
+    }
+    state.require("firstevent",       m_firstevent);
+    state.require("firstTriggerTime", m_firstTriggerTime);
+    state.require("firstTriggerTick", m_firstTriggerTick);
+    state.require("lastTriggerTick",  m_lastTriggerTick);
+    state.require("lastWindowTick",   m_lastWindowTick);
+    state.require("prescaled",        m_prescaled);
+    state.require("busy",             m_busy);
+    state.require("deadzone",         m_deadzone);
+}
 
-    return;
+//------------------------------------------------------------------------------
+void TriggerAlg::makeGemTileList(const Trigger::TileListBits& bits, LdfEvent::GemTileList& vetotilelist)
+{
+    vetotilelist.clear();
+    vetotilelist.init(bits.xzm(),bits.xzp(),bits.yzm(),bits.yzp(),bits.xy(),bits.rbn(),bits.na());
 }
 //------------------------------------------------------------------------------
-void TriggerAlg::bitSummary(std::ostream& out, std::string label, const std::map<unsigned int,unsigned int>& table)
+void TriggerAlg::bitSummary(std::ostream& out, std::string label, const Trigger::TriggerBitHistogram& table)
 {
     // purpose and method: make a summary of the bit frequencies to the stream
 
@@ -702,26 +1236,24 @@ void TriggerAlg::bitSummary(std::ostream& out, std::string label, const std::map
     static int col1=16; // width of first column
     out << endl << "             bit frequency: "<< label;
     out << endl << setw(col1) << "value"<< setw(6) << "count" ;
-    int j, grand_total=0;
+    int j;
     for(j=size-1; j>=0; --j) out << setw(6) << m_bitNames[1<<j];
     out << endl << setw(col1) <<" "<< setw(6) << "------"; 
     for( j=0; j<size; ++j) out << setw(6) << "-----";
-    vector<int>total(size);
-    for( map<unsigned int,unsigned int>::const_iterator it = table.begin(); it != table.end(); ++it)
+    for( unsigned int i=0; i<Trigger::TriggerBitHistogram::size; ++i)
     {
-        int i = (*it).first, n = (*it).second;
-        grand_total += n;
+        unsigned long n = table.count(i);
+        if( n==0 ) continue;
         out << endl << setw(col1)<< i << setw(6)<< n ;
-        for(j=size-1; j>=0; --j)
-        {
-            int m = ((i&(1<<j))!=0)? n :0;
-            total[j] += m;
-            out << setw(6) << m ;
-        }
+        for(j=size-1; j>=0; --j) out << setw(6) << (((i&(1<<j))!=0)? n :0);
     }
+    if( table.overflow()!=0 ) out << endl << setw(col1) << "overflow" << setw(6) << table.overflow();
+
+    vector<unsigned long> total(size);
+    table.marginals(&total[0], size);
     out << endl << setw(col1) <<" "<< setw(6) << "------"; 
     for( j=0; j<size; ++j) out << setw(6) << "-----";
-    out << endl << setw(col1) << "tot:" << setw(6)<< grand_total;
+    out << endl << setw(col1) << "tot:" << setw(6)<< table.total();
     for(j=size-1; j>=0; --j) out << setw(6) << total[j];
 
     return;
@@ -736,14 +1268,14 @@ enums::Lsf::LeakedPrescaler TriggerAlg::dgnPrescaler( unsigned triggerEngine )
 }
 
 
-StatusCode TriggerAlg::handleMetaEvent( LsfEvent::MetaEvent& metaEvent, unsigned int triggerEngine ) 
+StatusCode TriggerAlg::handleMetaEvent( LsfEvent::MetaEvent& metaEvent, unsigned int triggerEngine, const Configuration* config ) 
 {
-    if ( m_configSvc == 0 ) return StatusCode::FAILURE;
+    if ( config == 0 ) return StatusCode::FAILURE; // none without the ConfigSvc
   
-    metaEvent.setMootKey( m_configSvc->getMootKey() );
+    metaEvent.setMootKey( config->mootKey );
 
     unsigned handlerMask(0);  
-    unsigned fmxKey(0);
+    enums::Lsf::Mode mode = metaEvent.datagram().mode();
 
     lsfData::GammaHandler* gamma = const_cast<lsfData::GammaHandler*>(metaEvent.gammaFilter());
     unsigned gammaPS = LSF_INVALID_UINT;
@@ -751,18 +1283,12 @@ StatusCode TriggerAlg::handleMetaEvent( LsfEvent::MetaEvent& metaEvent, unsigned
     enums::Lsf::RsdState gammaState = enums::Lsf::INVALID;
     if ( gamma != 0 ) 
     {
-        const FswEfcSampler* efc = m_configSvc->getFSWPrescalerInfo( metaEvent.datagram().mode(), 
-                                                                     enums::Lsf::GAMMA, fmxKey );    
         handlerMask |= 1;
-        if ( efc != 0 ) 
+        gammaSamp = gamma->prescaler() ;
+        gammaState = gamma->state();
+        if ( ! fswPrescaleFactor(*config, mode, enums::Lsf::GAMMA, gamma->cfgKey(), gammaState, gammaSamp, gammaPS) ) 
         {
-            gammaSamp = gamma->prescaler() ;
-            gammaState = gamma->state();
-            gammaPS = efc->prescaleFactor(gammaState, gammaSamp);      
-            if ( ! checkFmxKey(fmxKey,gamma->cfgKey(),metaEvent.datagram().mode(),enums::Lsf::GAMMA) ) 
-            {
-                return StatusCode::FAILURE;
-            }
+            return StatusCode::FAILURE;
         }
         
         gamma->setPrescaleFactor(gammaPS);
@@ -774,18 +1300,12 @@ StatusCode TriggerAlg::handleMetaEvent( LsfEvent::MetaEvent& metaEvent, unsigned
     enums::Lsf::RsdState dgnState = enums::Lsf::INVALID;
     if ( dgn != 0 ) 
     {
-        dgnSamp = dgnPrescaler(triggerEngine);
-        const FswEfcSampler* efc = m_configSvc->getFSWPrescalerInfo( metaEvent.datagram().mode(), 
-                                                                     enums::Lsf::DGN, fmxKey  );    
         handlerMask |= 2;
-        if ( efc != 0 ) 
-        {      
-            dgnState = dgn->state();   
-            dgnPS = efc->prescaleFactor(dgnState, dgnSamp);
-            if ( ! checkFmxKey(fmxKey,dgn->cfgKey(),metaEvent.datagram().mode(),enums::Lsf::DGN) ) 
-            {
-                return StatusCode::FAILURE;
-            }
+        dgnSamp = dgnPrescaler(triggerEngine);
+        dgnState = dgn->state();   
+        if ( ! fswPrescaleFactor(*config, mode, enums::Lsf::DGN, dgn->cfgKey(), dgnState, dgnSamp, dgnPS) ) 
+        {
+            return StatusCode::FAILURE;
         }
     
         dgn->setPrescaleFactor(dgnPS);
@@ -796,18 +1316,12 @@ StatusCode TriggerAlg::handleMetaEvent( LsfEvent::MetaEvent& metaEvent, unsigned
     enums::Lsf::RsdState mipState = enums::Lsf::INVALID;
     if ( mip != 0 ) 
     {
-        const FswEfcSampler* efc = m_configSvc->getFSWPrescalerInfo( metaEvent.datagram().mode(), 
-                                                                     enums::Lsf::MIP, fmxKey  );    
         handlerMask |= 4;
-        if ( efc != 0 ) 
+        mipState = mip->state();
+        mipSamp = mip->prescaler();
+        if ( ! fswPrescaleFactor(*config, mode, enums::Lsf::MIP, mip->cfgKey(), mipState, mipSamp, mipPS) ) 
         {
-            mipState = mip->state();
-            mipSamp = mip->prescaler();
-            mipPS = efc->prescaleFactor(mipState, mipSamp);      
-            if ( ! checkFmxKey(fmxKey,mip->cfgKey(),metaEvent.datagram().mode(),enums::Lsf::MIP) ) 
-            {
-                return StatusCode::FAILURE;
-            }
+            return StatusCode::FAILURE;
         }
     
         mip->setPrescaleFactor(mipPS);
@@ -818,18 +1332,12 @@ StatusCode TriggerAlg::handleMetaEvent( LsfEvent::MetaEvent& metaEvent, unsigned
     lsfData::HipHandler* hip = const_cast<lsfData::HipHandler*>(metaEvent.hipFilter());
     if ( hip != 0 ) 
     {
-        const FswEfcSampler* efc = m_configSvc->getFSWPrescalerInfo( metaEvent.datagram().mode(), 
-                                                                     enums::Lsf::HIP, fmxKey  );    
         handlerMask |= 8;
-        if ( efc != 0 ) 
+        hipState = hip->state();
+        hipSamp = hip->prescaler();
+        if ( ! fswPrescaleFactor(*config, mode, enums::Lsf::HIP, hip->cfgKey(), hipState, hipSamp, hipPS) ) 
         {
-            hipState = hip->state();
-            hipSamp = hip->prescaler();
-            hipPS = efc->prescaleFactor(hipState, hipSamp);
-            if ( ! checkFmxKey(fmxKey,hip->cfgKey(),metaEvent.datagram().mode(),enums::Lsf::HIP) ) 
-            {
-                return StatusCode::FAILURE;
-            }
+            return StatusCode::FAILURE;
         }
     
         hip->setPrescaleFactor(hipPS);
@@ -845,10 +1353,26 @@ StatusCode TriggerAlg::handleMetaEvent( LsfEvent::MetaEvent& metaEvent, unsigned
     return StatusCode::SUCCESS;
 }
 
+bool TriggerAlg::fswPrescaleFactor(const Configuration& config, enums::Lsf::Mode mode, enums::Lsf::HandlerId handler, unsigned cfgKey,
+                                   enums::Lsf::RsdState state, enums::Lsf::LeakedPrescaler sampler, unsigned& factor)
+{
+    Trigger::FswPrescaleCache::Entry entry;
+    {
+        // another event may be adding an entry for its mode
+        Trigger::Mutex::Lock lock(m_configurationLock);
+        entry = config.fswPrescales.entry(*m_configSvc, mode, handler);
+    }
+    if ( entry.efc == 0 ) return true;
+
+    factor = entry.efc->prescaleFactor(state, sampler);
+
+    return checkFmxKey(entry.fmxKey, cfgKey, mode, handler);
+}
+
 bool TriggerAlg::checkFmxKey(unsigned mootKey, 
                              unsigned evtKey, 
                              enums::Lsf::Mode mode, 
-                             enums::Lsf::HandlerId handler) const 
+                             enums::Lsf::HandlerId handler)
 {
     // mootKey == 0 means we didn't get a cdm from MOOT, but from a file, don't really check
     if ( mootKey == 0 ) return true;
@@ -859,10 +1383,10 @@ bool TriggerAlg::checkFmxKey(unsigned mootKey,
 
     // only warn once per mode X handler
     int handlerXMode = 1000*mode + handler;
-    static std::set<int> warnedSet;
-    if ( warnedSet.find(handlerXMode) == warnedSet.end() ) 
+    Trigger::Mutex::Lock lock(m_fmxWarnedLock);
+    if ( m_fmxWarned.find(handlerXMode) == m_fmxWarned.end() ) 
     {
-        warnedSet.insert(handlerXMode);
+        m_fmxWarned.insert(handlerXMode);
         MsgStream log(msgSvc(), name());
         log << MSG::ERROR << "FMX key from moot (" << mootKey 
             << ") doesn't match key from data (" << evtKey << " for ";
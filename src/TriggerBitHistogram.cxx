@@ -0,0 +1,79 @@
+/**
+*  @file TriggerBitHistogram.cxx
+*  @brief Implementation of the class TriggerBitHistogram
+*
+*  $Header:  $
+*/
+
+#include "TriggerBitHistogram.h"
+
+#include <sstream>
+
+using namespace Trigger;
+
+void TriggerBitHistogram::clear()
+{
+    for( unsigned int i=0; i<size; ++i) m_count[i]=0;
+    m_overflow=0;
+}
+
+unsigned long TriggerBitHistogram::total()const
+{
+    unsigned long sum(m_overflow);
+    for( unsigned int i=0; i<size; ++i) sum += m_count[i];
+    return sum;
+}
+
+void TriggerBitHistogram::marginals(unsigned long* marginal, int nbits)const
+{
+    // no branches in the inner loop, so that it vectorizes
+    for( int j=0; j<nbits; ++j){
+        unsigned long sum(0);
+        for( unsigned int i=0; i<size; ++i) sum += m_count[i] * ((i>>j)&1);
+        marginal[j] = sum;
+    }
+}
+
+TriggerBitHistogram& TriggerBitHistogram::operator+=(const TriggerBitHistogram& other)
+{
+    for( unsigned int i=0; i<size; ++i) m_count[i] += other.m_count[i];
+    m_overflow += other.m_overflow;
+    return *this;
+}
+
+void TriggerBitHistogram::write(std::ostream& out, const std::string& label)const
+{
+    for( unsigned int i=0; i<size; ++i){
+        if( m_count[i]!=0 ) out << label << ',' << i << ',' << m_count[i] << '\n';
+    }
+    if( m_overflow!=0 ) out << label << ",overflow," << m_overflow << '\n';
+}
+
+bool TriggerBitHistogram::read(std::istream& in, const std::string& label)
+{
+    std::string line;
+    while( std::getline(in, line) ){
+        std::istringstream fields(line);
+        std::string stage, value;
+        if( !std::getline(fields, stage, ',') || stage!=label ) continue;
+        unsigned long count(0);
+        if( !std::getline(fields, value, ',') || !(fields >> count) ) return false;
+        if( value=="overflow" ){
+            m_overflow += count;
+            continue;
+        }
+        std::istringstream bits(value);
+        unsigned int i(size);
+        if( !(bits >> i) || i>=size ) return false;
+        m_count[i] += count;
+    }
+    return true;
+}
+
+bool TriggerBitHistogram::operator==(const TriggerBitHistogram& other)const
+{
+    for( unsigned int i=0; i<size; ++i){
+        if( m_count[i]!=other.m_count[i] ) return false;
+    }
+    return m_overflow==other.m_overflow;
+}
@@ -0,0 +1,64 @@
+/** @file TriggerBitHistogram.h
+  *  @brief Declaration of the class TriggerBitHistogram
+  *
+  *  $Header:  $
+*/
+
+#ifndef Trigger_TriggerBitHistogram_h
+#define Trigger_TriggerBitHistogram_h
+
+#include <iostream>
+#include <string>
+
+namespace Trigger {
+
+/** @class TriggerBitHistogram
+    @brief number of events for each trigger bit pattern
+
+    One counter for each value of the 8 low bits of the trigger word, so that filling is a
+    single increment; larger values are counted in the overflow. Histograms of separate jobs
+    are merged by adding them.
+*/
+class TriggerBitHistogram {
+public:
+    enum { size = 256 };
+
+    TriggerBitHistogram(){ clear(); }
+
+    void clear();
+
+    /// count an event
+    void fill(unsigned int bits){ if( bits<size ) ++m_count[bits]; else ++m_overflow; }
+
+    /// events with this pattern
+    unsigned long count(unsigned int bits)const{ return m_count[bits]; }
+
+    /// events with a pattern beyond the histogram
+    unsigned long overflow()const{ return m_overflow; }
+
+    /// all events, including the overflow
+    unsigned long total()const;
+
+    /// for each of the first nbits bits, the events that have it set, excluding the overflow
+    void marginals(unsigned long* marginal, int nbits)const;
+
+    /// add the counts of another histogram
+    TriggerBitHistogram& operator+=(const TriggerBitHistogram& other);
+
+    /// write "label,value,count" lines for the filled patterns, with "overflow" for the value of the overflow
+    void write(std::ostream& out, const std::string& label)const;
+
+    /// add the counts of the lines with this label that write made; other lines are skipped.
+    /// @return false if a line of the label cannot be read
+    bool read(std::istream& in, const std::string& label);
+
+    /// the same counts, including the overflow
+    bool operator==(const TriggerBitHistogram& other)const;
+
+private:
+    unsigned long m_count[size];
+    unsigned long m_overflow;
+};
+
+}
+#endif
@@ -17,15 +17,24 @@
 #include "Event/TopLevel/EventModel.h"
 #include "Event/TopLevel/Event.h"
 #include "Event/TopLevel/DigiEvent.h"
-#include "Event/Digi/TkrDigi.h"
-#include "Event/Digi/AcdDigi.h"
 
 #include "Event/Trigger/TriggerInfo.h"
+#include "Event/Digi/AcdDigi.h"
+
+#include "Trigger/PrimitiveStatus.h"
+#include "Trigger/TkrLayerBits.h"
+
+#include "LdfEvent/Gem.h"
 
 #include "enums/TriggerBits.h"
 
 #include "TriggerTables.h"
+#include "TriggerPrimitives.h"
+#include "AcdTileTable.h"
+#include "TdsHandle.h"
+#include "Mutex.h"
 #include "EnginePrescaleCounter.h"
+#include "ConfigEngineTable.h"
 #include "ConfigSvc/IConfigSvc.h"
 
 #include "CalXtalResponse/ICalTrigTool.h"
@@ -36,26 +45,20 @@
 #include <map>
 #include <vector>
 #include <algorithm>
+#include <stdexcept>
 
-namespace { // local definitions of convenient inline functions
-    inline unsigned three_in_a_row(unsigned bits)
-    {
-        unsigned bitword = 0;
-        for(int i=0; i<16; i++){
-            if((bits&7)==7)  bitword |= 1 << i;
-            bits >>= 1;
-        }
-        return bitword;
-    }
-    inline unsigned layer_bit(int layer){ return 1 << layer;}
-}
 //------------------------------------------------------------------------------
 /*! \class TriggerInfoAlg
 \brief  alg that sets trigger information
 
 @section Attributes for job options:
 @param run [0] For setting the run number
+@param lazyPrimitives [false] skip the calorimeter primitives when no values of them could select
+an engine that passes, see Trigger::PrimitiveStatus
 
+Nothing in the algorithm is changed by an event, but for the one step that makes what it derives
+from a trigger configuration when the configuration is first seen, which holds a lock: a
+Configuration is not changed after, and everything else is local to execute.
 */
 
 class TriggerInfoAlg : public Algorithm {
@@ -69,26 +72,26 @@ public:
     StatusCode finalize();
 
 private:
-    //! determine tracker trigger bits
-    unsigned int  tracker(unsigned short &tkrVector);
+    /// what is derived from a trigger configuration
+    struct Configuration
+    {
+        Trigger::AcdTileTable acdTiles;  ///< ACD tiles, with the ROI
+        EnginePrescaleCounter engines;   ///< engines for lazyPrimitives: only canPass is used
 
-    /// determine cal trigger bits
-    /// \param calLoVector destination for callo triggers (1 bit per
-    /// tower
-    /// \param calLoVector destination for calhi triggers (1 bit per
-    /// tower
-    StatusCode calorimeter(unsigned short &calLoVector, unsigned short &calHiVector);
+        /// the default configuration
+        explicit Configuration(const std::vector<int>& prescales) : engines(prescales) {}
 
-    //! calculate ACD trigger bits
-    /// @return the bits
-    unsigned int  anticoincidence(unsigned short &cnoVector, std::vector<unsigned int>& vetotilelist);
+        /// a ConfigSvc configuration
+        Configuration(const TrgConfig& tcf, const std::vector<int>& prescales);
+    };
 
-    void roiDefaultSetup();
-    unsigned int throttle(unsigned int tkrVector, std::vector<unsigned int>& tilelist, unsigned short &roiVector); 
+    /// the configuration of the event: made when a ConfigSvc configuration is first seen,
+    /// the only step that changes the algorithm, under m_configurationLock. 0 if it cannot be had
+    const Configuration* configuration(MsgStream& log);
 
-    void makeTileListMap(std::vector<unsigned int>&tileList, Event::TriggerInfo::TileList& tileListMap);
+    /// true unless the engines reject the event whatever the calorimeter primitives
+    bool calorimeterNeeded(const Configuration& config, unsigned int trigger_bits)const;
 
-    int                  m_event;
     StringProperty       m_table;
     IntegerArrayProperty m_prescale;
 
@@ -103,14 +106,25 @@ private:
 
 
     Trigger::TriggerTables* m_triggerTables;
-    EnginePrescaleCounter* m_pcounter;
-    TrgRoi *m_roi;
+
+    /// configurations by MOOT key and TrgConfig, kept to the end: an event may still use one
+    typedef std::map<std::pair<unsigned int, const TrgConfig*>, const Configuration*> ConfigurationMap;
+    ConfigurationMap     m_configurations;
+    Trigger::Mutex       m_configurationLock;     ///< for the lookup and insertion in m_configurations
+    const Configuration* m_defaultConfiguration;  ///< without ConfigSvc
+
+    Trigger::TriggerPrimitives m_primitives;  ///< computes the primitives from the digis
+
+    Trigger::TdsHandle<Event::AcdDigiCol> m_acdDigis;
+    Trigger::TdsHandle<LdfEvent::Gem>     m_gem;
 
     // The following for test potential Compton Trigger options
     StringProperty m_towersOnProperty;    // How we communicate from JO files
     unsigned int   m_towersToTurnOn;      // The representation we use in the code
     StringProperty m_bilayersOnProperty;  
     unsigned int   m_bilayersToTurnOn;
+
+    BooleanProperty m_lazyPrimitives;     ///< skip primitives that cannot change the engine decision
 };
 
 //------------------------------------------------------------------------------
@@ -120,12 +134,14 @@ DECLARE_ALGORITHM_FACTORY(TriggerInfoAlg);
 //------------------------------------------------------------------------------
 /// 
 TriggerInfoAlg::TriggerInfoAlg(const std::string& name, ISvcLocator* pSvcLocator) 
-  : Algorithm(name, pSvcLocator), m_configSvc(0), m_calTrigTool(0), m_pcounter(0)
+  : Algorithm(name, pSvcLocator), m_configSvc(0), m_calTrigTool(0), m_triggerTables(0), m_defaultConfiguration(0)
+  , m_acdDigis(EventModel::Digi::AcdDigiCol), m_gem("/Event/Gem")
 {
-    declareProperty("engine",           m_table              = "ConfigSvc");        // set to "default"  to use default engine table
+    declareProperty("engine",           m_table              = "ConfigSvc");        // set to "default"  to use default engine table, or a table file name
     declareProperty("prescale",         m_prescale           = std::vector<int>()); // vector of prescale factors
     declareProperty("TowersToTurnOn",   m_towersOnProperty   = "0x000");            // Turn "on" these towers...
     declareProperty("BilayersToTurnOn", m_bilayersOnProperty = "0x000");            // Turn "on" these bilayers in the above towers
+    declareProperty("lazyPrimitives",   m_lazyPrimitives     = false);              // skip the CAL primitives if the engines reject the event anyway
 
     for( int i=0; i<8; ++i) 
     { 
@@ -175,12 +191,19 @@ StatusCode TriggerInfoAlg::initialize()
                 log << MSG::ERROR << "failed to get the ConfigSvc" << endreq;
                 return sc;
             }
-            m_pcounter=new EnginePrescaleCounter(m_prescale.value());
         }
         else
         {
             // selected trigger tables and engines for event selection
-            m_triggerTables = new Trigger::TriggerTables(m_table.value(), m_prescale.value());
+            try
+            {
+                m_triggerTables = new Trigger::TriggerTables(m_table.value(), m_prescale.value());
+            }
+            catch(const std::exception& e)
+            {
+                log << MSG::ERROR << "failed to set up trigger tables: " << e.what() << endreq;
+                return StatusCode::FAILURE;
+            }
 
             log << MSG::INFO << "Trigger tables: \n";
             m_triggerTables->print(log.stream());
@@ -188,10 +211,14 @@ StatusCode TriggerInfoAlg::initialize()
         }
     }
 
-    if (!m_pcounter) // set up default ROI config
+    m_primitives.initialize(m_calTrigTool, m_towersToTurnOn, m_bilayersToTurnOn);
+
+    m_acdDigis.initialize(eventSvc());
+    m_gem.initialize(eventSvc());
+
+    if (!m_configSvc) // set up default ROI config, otherwise from each ConfigSvc configuration
     {
-        m_roi = new TrgRoi;
-        roiDefaultSetup();
+        m_defaultConfiguration = new Configuration(m_prescale.value());
     }
 
     return sc;
@@ -208,64 +235,33 @@ StatusCode TriggerInfoAlg::execute()
     StatusCode  sc = StatusCode::SUCCESS;
     MsgStream   log( msgSvc(), name() );
 
-    // set bits in the trigger word
-    unsigned short tkrVector           = 0;
-    unsigned short cnoVector           = 0;
-    unsigned short roiVector           = 0;
-    unsigned short calLoVector         = 0;
-    unsigned short calHiVector         = 0;
-    unsigned short deltaEventTime      = 0xffff;
-    unsigned short deltaWindowOpenTime = 0xffff;
-
-    std::vector<unsigned int> tileList;
-
-    unsigned int trigger_bits = tracker(tkrVector) | anticoincidence(cnoVector,tileList);
-
-    /// process calorimeter trigger bits
-    if (calorimeter(calLoVector, calHiVector).isFailure())
-        return StatusCode::FAILURE;
+    const Configuration* config = m_configSvc ? configuration(log) : m_defaultConfiguration;
+    if (config == 0) return StatusCode::FAILURE;
 
-    trigger_bits |= (calLoVector ? enums::b_LO_CAL:0) |(calHiVector ? enums::b_HI_CAL:0);
+    Trigger::TriggerPrimitives::Values values;
+    m_primitives.compute(config->acdTiles, TriRowBitsTds::TkrLayerBits::get(eventSvc()), m_acdDigis.find(), log, values);
 
-    if (m_pcounter) //using ConfigSvc
+    /// process calorimeter trigger bits, the expensive ones, last
+    unsigned int computed = Trigger::PrimitiveStatus::ALL;
+    if (m_lazyPrimitives && !calorimeterNeeded(*config, values.triggerBits))
     {
-        const TrgConfig* tcf = m_configSvc->getTrgConfig();
-
-        m_roi = const_cast<TrgRoi*>(tcf->roi());
-        
-        if (m_roi == 0) 
-        {
-            log << MSG::ERROR << "Failed to get ROI mapping from MOOT" << endreq;
-            return StatusCode::FAILURE;
-        } 
+        computed &= ~Trigger::PrimitiveStatus::CAL;
     }
-
-    if (tkrVector!=0 && !tileList.empty())
+    else if (m_primitives.computeCalorimeter(values).isFailure())
     {
-        trigger_bits |= throttle(tkrVector,tileList,roiVector);
+        return StatusCode::FAILURE;
     }
 
-    // Define the mask map for struck tiles
-    Event::TriggerInfo::TileList tileListMap;
-
-    // Translate from tile list vector to tile list map
-    makeTileListMap(tileList, tileListMap);
-
     // Create and fill the TriggerInfo TDS object
-    Event::TriggerInfo* triggerInfo = new Event::TriggerInfo();
-
-    triggerInfo->initTriggerInfo(trigger_bits, 
-                                 tkrVector, 
-                                 roiVector, 
-                                 calLoVector, 
-                                 calHiVector, 
-                                 cnoVector, 
-                                 deltaEventTime,
-                                 deltaWindowOpenTime, 
-                                 tileListMap);
+    Event::TriggerInfo* triggerInfo = values.makeTriggerInfo();
 
     sc = eventSvc()->registerObject("/Event/TriggerInfo", triggerInfo);
 
+    if (sc.isSuccess() && m_lazyPrimitives)
+    {
+        sc = eventSvc()->registerObject(Trigger::PrimitiveStatus::path(), new Trigger::PrimitiveStatus(computed));
+    }
+
 
     return sc;
 }
@@ -279,244 +275,66 @@ StatusCode TriggerInfoAlg::finalize() {
 
     MsgStream log(msgSvc(), name());
 
+    log << MSG::DEBUG << "Trigger configurations used: " << m_configurations.size() << endreq;
+
+    for (ConfigurationMap::iterator it = m_configurations.begin(); it != m_configurations.end(); ++it)
+    {
+        delete it->second;
+    }
+    m_configurations.clear();
+    delete m_defaultConfiguration;
+    m_defaultConfiguration = 0;
+
     return sc;
 }
 
 //------------------------------------------------------------------------------
-unsigned int TriggerInfoAlg::tracker(unsigned short &tkrVector)
+TriggerInfoAlg::Configuration::Configuration(const TrgConfig& tcf, const std::vector<int>& prescales)
+  : acdTiles(*tcf.roi()), engines(prescales)
 {
-    // purpose and method: determine if there is tracker trigger, any 3-in-a-row, 
-    //and fill out the TDS class TriRowBits, with the complete 3-in-a-row information
-    MsgStream   log( msgSvc(), name() );
-
-    // Set default return value
-    tkrVector = 0;
-
-    // Find the TkrDigi collection first
+    Trigger::ConfigEngineTable table;
+    table.set(&tcf);
+    engines.configure(table);
+}
 
-    SmartDataPtr<Event::TkrDigiCol> planes(eventSvc(), EventModel::Digi::TkrDigiCol);
-    if( planes == 0 )
+//------------------------------------------------------------------------------
+const TriggerInfoAlg::Configuration* TriggerInfoAlg::configuration(MsgStream& log)
+{
+    const TrgConfig* tcf = m_configSvc->getTrgConfig();
+    if (tcf == 0)
     {
-        log << MSG::DEBUG << "No tkr digis found" << endreq;
+        log << MSG::ERROR << "Failed to get trigger config from ConfigSvc." << endreq;
         return 0;
     }
 
-    log << MSG::DEBUG << planes->size() << " tracker planes found with hits" << endreq;
+    std::pair<unsigned int, const TrgConfig*> key(m_configSvc->getMootKey(), tcf);
 
-    // define a map to sort hit planes according to tower and plane axis
-    typedef std::pair<idents::TowerId, idents::GlastAxis::axis> Key;
-    typedef std::map<Key, unsigned int> Map;
-    Map layer_bits;
-
-    // this loop sorts the hits by setting appropriate bits in the tower-plane hit map
-    for( Event::TkrDigiCol::const_iterator it = planes->begin(); it != planes->end(); ++it){
-        const Event::TkrDigi& t = **it;
-        if( t.getNumHits()== 0) continue; // this can happen if there are dead strips 
-        layer_bits[std::make_pair(t.getTower(), t.getView())] |= layer_bit(t.getBilayer());
-    }
+    // another event may be inserting the configuration: the map must not be read meanwhile
+    Trigger::Mutex::Lock lock(m_configurationLock);
+    ConfigurationMap::const_iterator it = m_configurations.find(key);
+    if (it != m_configurations.end()) return it->second;
 
-    // Are we modifying the tower/bilayer hit pattern?
-    if (m_towersToTurnOn && m_bilayersToTurnOn)
+    if (tcf->roi() == 0) 
     {
-        // Loop over all possible towers
-        for(int idx = 0; idx < 16; idx++)
-        {
-            // Is the tower mast bit set for this tower?
-            if (m_towersToTurnOn & 1<<idx)
-            {
-                // Turn on the bits for the bilayers in our "on" mask
-                layer_bits[std::make_pair(idents::TowerId(idx), idents::GlastAxis::X)] |= m_bilayersToTurnOn;
-                layer_bits[std::make_pair(idents::TowerId(idx), idents::GlastAxis::Y)] |= m_bilayersToTurnOn;
-            }
-        }
-    }
-
-    bool tkr_trig_flag = false;
-    tkrVector=0;
-    // now look for a three in a row in x-y coincidence
-    for( Map::iterator itr = layer_bits.begin(); itr !=layer_bits.end(); ++ itr){
-
-        Key theKey=(*itr).first;
-        idents::TowerId tower = theKey.first;
-        if( theKey.second==idents::GlastAxis::X) {
-            // found an x: and with corresponding Y (if exists)
-            unsigned int
-                xbits = (*itr).second,
-                ybits = layer_bits[std::make_pair(tower, idents::GlastAxis::Y)];
-
-            unsigned int bitword = three_in_a_row(xbits & ybits);
-            if(bitword) {
-                // set bit in the tkr vector
-                tkrVector|=1<<tower.id();
-                //remember there was a 3-in-a-row but keep looking in other towers
-                tkr_trig_flag=true;
-            }
-
-        }
-    }
-
-    //returns the digi base word, for consistency with the cal and acd.
-    if(tkr_trig_flag) return enums::b_Track;
-    else return 0;
-}
-
-//------------------------------------------------------------------------------
-unsigned int TriggerInfoAlg::anticoincidence(unsigned short& cnoVector, std::vector<unsigned int> &vetotilelist)
-{
-    // purpose and method: calculate ACD trigger bits from the list of hit tiles
-
-    // purpose: set ACD trigger bits
-    MsgStream   log( msgSvc(), name() );
-
-    unsigned int ret=0;
-    cnoVector=0;
-
-    // Look up the ACD digi collection
-    SmartDataPtr<Event::AcdDigiCol> tiles(eventSvc(), EventModel::Digi::AcdDigiCol);
-    if( tiles == 0 ) {
-        log << MSG::DEBUG << "No acd digis found" << endreq;
-        return ret;
-    }
-    log << MSG::DEBUG << tiles->size() << " tiles found with hits" << endreq;
-
-    for( Event::AcdDigiCol::const_iterator it = tiles->begin(); it !=tiles->end(); ++it){
-        // check if hitMapBit is set (veto) which will correspond to 0.3 MIP.
-        // 20060109 Agreed at Analysis Meeting that onboard threshold is 0.3 MIP
-        const Event::AcdDigi& digi = **it;
-
-        // If the digi is purely overlay, then skip it for the trigger
-        if (digi.getStatus() == (unsigned int)Event::AcdDigi::DIGI_OVERLAY) continue;
-        
-        // Digi id
-        unsigned int id=digi.getId().id();
-        if (id==899)id=1000; // NA tiles are 899 sometimes 
-
-        // veto tile list
-        if ( (digi.getHitMapBit(Event::AcdDigi::A) || digi.getHitMapBit(Event::AcdDigi::B))  ){
-            vetotilelist.push_back(id);
-            //ret |= enums::b_ACDL; 
-        }
-
-        // now trigger high if either PMT is above threshold
-        if (   digi.getCno(Event::AcdDigi::A) || digi.getCno(Event::AcdDigi::B) ){
-            ret |= enums::b_ACDH;
-            // cno vector
-            unsigned int garc,gafe;
-            garc=gafe=0xff;
-            if (digi.getCno(Event::AcdDigi::A)){
-                unsigned int pmt= Event::AcdDigi::A;
-                idents::AcdId::convertToGarcGafe(id,pmt,garc,gafe);
-                cnoVector|=1<<garc;
-            }
-            if (digi.getCno(Event::AcdDigi::B)){
-                unsigned int pmt= Event::AcdDigi::B;
-                idents::AcdId::convertToGarcGafe(id,pmt,garc,gafe);
-                cnoVector|=1<<garc;
-            }
-        }
+        log << MSG::ERROR << "Failed to get ROI mapping from MOOT" << endreq;
+        return 0;
     } 
-    return ret;
-}
-
-StatusCode TriggerInfoAlg::calorimeter(unsigned short &calLoVector, unsigned short &calHiVector) 
-{
-    if(m_calTrigTool->getCALTriggerVector(idents::CalXtalId::LARGE, calLoVector).isFailure())
-        return StatusCode::FAILURE;
-    if(m_calTrigTool->getCALTriggerVector(idents::CalXtalId::SMALL, calHiVector).isFailure())
-        return StatusCode::FAILURE;
-
-    return StatusCode::SUCCESS;
-}
 
-//------------------------------------------------------------------------------
-unsigned int TriggerInfoAlg::throttle(unsigned int tkrVector, std::vector<unsigned int>& tilelist, unsigned short &roiVector){
-    unsigned int triggered =0;
-    roiVector=0;
-    for (unsigned int i=0;i<tilelist.size();i++){
-        std::vector<unsigned long> rr=m_roi->roiFromName(tilelist[i]);
-        for (unsigned int j=0;j<rr.size();j++){
-            if (tkrVector & (1<<rr[j])){
-                triggered|=enums::b_ROI;
-            }
-            roiVector|=1<<rr[j];
-        }
-    }
-    return triggered;
+    const Configuration* config = new Configuration(*tcf, m_prescale.value());
+    m_configurations[key] = config;
+    return config;
 }
 
 //------------------------------------------------------------------------------
-void TriggerInfoAlg::roiDefaultSetup()
+bool TriggerInfoAlg::calorimeterNeeded(const Configuration& config, unsigned int trigger_bits)const
 {
-    m_roi->setRoiRegister(  0 , 0x30001 );
-    m_roi->setRoiRegister(  1 , 0xc0006 );
-    m_roi->setRoiRegister(  2 , 0x110008 );
-    m_roi->setRoiRegister(  3 , 0x660033 );
-    m_roi->setRoiRegister(  4 , 0x8800cc );
-    m_roi->setRoiRegister(  5 , 0x3300110 );
-    m_roi->setRoiRegister(  6 , 0xcc00660 );
-    m_roi->setRoiRegister(  7 , 0x11000880 );
-    m_roi->setRoiRegister(  8 , 0x66003300 );
-    m_roi->setRoiRegister(  9 , 0x8800cc00 );
-    m_roi->setRoiRegister( 10 , 0x30001000 );
-    m_roi->setRoiRegister( 11 , 0xc0006000 );
-    m_roi->setRoiRegister( 12 , 0x8000 );
-    m_roi->setRoiRegister( 13 , 0x10000 );
-    m_roi->setRoiRegister( 14 , 0x1100011 );
-    m_roi->setRoiRegister( 15 , 0x10001100 );
-    m_roi->setRoiRegister( 16 , 0x110001 );
-    m_roi->setRoiRegister( 17 , 0x11000110 );
-    m_roi->setRoiRegister( 18 , 0x1000 );
-    m_roi->setRoiRegister( 22 , 0x10000 );
-    m_roi->setRoiRegister( 23 , 0x60003 );
-    m_roi->setRoiRegister( 24 , 0x8000c );
-    m_roi->setRoiRegister( 25 , 0x30001 );
-    m_roi->setRoiRegister( 26 , 0xc0006 );
-    m_roi->setRoiRegister( 27 , 0x8 );
-    m_roi->setRoiRegister( 31 , 0x80000 );
-    m_roi->setRoiRegister( 32 , 0x8800088 );
-    m_roi->setRoiRegister( 33 , 0x80008800 );
-    m_roi->setRoiRegister( 34 , 0x880008 );
-    m_roi->setRoiRegister( 35 , 0x88000880 );
-    m_roi->setRoiRegister( 36 , 0x8000 );
-    m_roi->setRoiRegister( 40 , 0x10000000 );
-    m_roi->setRoiRegister( 41 , 0x60003000 );
-    m_roi->setRoiRegister( 42 , 0x8000c000 );
-    m_roi->setRoiRegister( 43 , 0x30001000 );
-    m_roi->setRoiRegister( 44 , 0xc0006000 );
-    m_roi->setRoiRegister( 45 , 0x8000 );
-}
+    // with a GEM (real data) the engine is chosen from its condition summary: nothing is known here
+    if (m_gem.find() != 0) return true;
 
-//------------------------------------------------------------------------------
-void TriggerInfoAlg::makeTileListMap(std::vector<unsigned int>&tileList, Event::TriggerInfo::TileList& tileListMap)
-{
-    MsgStream log(msgSvc(), name());
-
-    // Clear the map and zero out the values
-    tileListMap.clear();
-    tileListMap["xzm"] = 0;
-    tileListMap["xzp"] = 0;
-    tileListMap["yzm"] = 0;
-    tileListMap["yzp"] = 0;
-    tileListMap["xy"]  = 0;
-    tileListMap["rbn"] = 0;
-    tileListMap["na"]  = 0;
-
-    // Loop through the input vector and translate to bit map
-    for (std::vector<unsigned int>::iterator tileItr = tileList.begin(); tileItr != tileList.end(); tileItr++)
-    {
-        unsigned int id       = *tileItr;
-        unsigned int gemIndex = idents::AcdId::gemIndexFromTile(id);
-
-        // Now do a look up...
-        if      (gemIndex <  16) tileListMap["xzm"] |= 1 <<  gemIndex;
-        else if (gemIndex <  32) tileListMap["xzp"] |= 1 << (gemIndex - 16);
-        else if (gemIndex <  48) tileListMap["yzm"] |= 1 << (gemIndex - 32);
-        else if (gemIndex <  64) tileListMap["yzp"] |= 1 << (gemIndex - 48);
-        else if (gemIndex <  89) tileListMap["xy"]  |= 1 << (gemIndex - 64);
-        else if (gemIndex < 104) tileListMap["rbn"] |= 1 << (gemIndex - 96);
-        else if (gemIndex < 123) tileListMap["na"]  |= 1 << (gemIndex - 112);
-        else log << MSG::ERROR << "Bad tile gem index: " << gemIndex << endreq;
-    }
+    int known   = Trigger::TriggerPrimitives::gemConditions(trigger_bits);
+    int unknown = LdfEvent::Gem::CALLE | LdfEvent::Gem::CALHE;
 
-    return;
+    if (m_triggerTables) return m_triggerTables->canPass(known, unknown);
+    if (m_configSvc)     return config.engines.canPass(known, unknown);
+    return true; // no engines: selection is on the trigger bits themselves
 }
@@ -0,0 +1,220 @@
+/**
+*  @file TriggerPrimitives.cxx
+*  @brief Implementation of the class TriggerPrimitives
+*
+*  $Header:  $
+*/
+
+#include "TriggerPrimitives.h"
+
+#include "GaudiKernel/MsgStream.h"
+
+#include "Event/Trigger/TriggerInfo.h"
+
+#include "Trigger/TkrLayerBits.h"
+
+#include "LdfEvent/Gem.h"
+
+#include "enums/TriggerBits.h"
+
+#include "CalXtalResponse/ICalTrigTool.h"
+
+using namespace Trigger;
+
+//------------------------------------------------------------------------------
+void TriggerPrimitives::Values::clear()
+{
+    triggerBits         = 0;
+    tkrVector           = 0;
+    roiVector           = 0;
+    calLoVector         = 0;
+    calHiVector         = 0;
+    cnoVector           = 0;
+    deltaEventTime      = 0xffff;
+    deltaWindowOpenTime = 0xffff;
+    vetoTiles.clear();
+}
+
+//------------------------------------------------------------------------------
+Event::TriggerInfo* TriggerPrimitives::Values::makeTriggerInfo()const
+{
+    Event::TriggerInfo* triggerInfo = new Event::TriggerInfo();
+    fillTriggerInfo(*triggerInfo);
+    return triggerInfo;
+}
+
+//------------------------------------------------------------------------------
+void TriggerPrimitives::Values::fillTriggerInfo(Event::TriggerInfo& triggerInfo)const
+{
+    // Define the mask map for struck tiles
+    Event::TriggerInfo::TileList tileListMap;
+    vetoTiles.toTileList(tileListMap);
+
+    triggerInfo.initTriggerInfo(triggerBits, 
+                                tkrVector, 
+                                roiVector, 
+                                calLoVector, 
+                                calHiVector, 
+                                cnoVector, 
+                                deltaEventTime,
+                                deltaWindowOpenTime, 
+                                tileListMap);
+}
+
+//------------------------------------------------------------------------------
+TriggerPrimitives::TriggerPrimitives()
+: m_calTrigTool(0)
+, m_towersToTurnOn(0)
+, m_bilayersToTurnOn(0)
+{
+}
+
+//------------------------------------------------------------------------------
+void TriggerPrimitives::initialize(ICalTrigTool* calTrigTool, unsigned int towersToTurnOn, unsigned int bilayersToTurnOn)
+{
+    m_calTrigTool      = calTrigTool;
+    m_towersToTurnOn   = towersToTurnOn;
+    m_bilayersToTurnOn = bilayersToTurnOn;
+}
+
+//------------------------------------------------------------------------------
+void TriggerPrimitives::compute(const AcdTileTable& acdTiles,
+                                const TriRowBitsTds::TkrLayerBits* layerBits, const Event::AcdDigiCol* acdDigis,
+                                MsgStream& log, Values& values)const
+{
+    values.clear();
+
+    unsigned short roiTowers = 0;
+    values.triggerBits = tracker(layerBits, log, values.tkrVector)
+                       | anticoincidence(acdTiles, acdDigis, log, values.cnoVector, values.vetoTiles, roiTowers);
+
+    // the ROI: towers in the region of a veto tile that also have a tracker trigger
+    if (values.tkrVector!=0)
+    {
+        values.roiVector = roiTowers;
+        if ((values.roiVector & values.tkrVector) != 0) values.triggerBits |= enums::b_ROI;
+    }
+}
+
+//------------------------------------------------------------------------------
+StatusCode TriggerPrimitives::computeCalorimeter(Values& values)const
+{
+    if(m_calTrigTool->getCALTriggerVector(idents::CalXtalId::LARGE, values.calLoVector).isFailure())
+        return StatusCode::FAILURE;
+    if(m_calTrigTool->getCALTriggerVector(idents::CalXtalId::SMALL, values.calHiVector).isFailure())
+        return StatusCode::FAILURE;
+
+    values.triggerBits |= (values.calLoVector ? enums::b_LO_CAL:0) |(values.calHiVector ? enums::b_HI_CAL:0);
+
+    return StatusCode::SUCCESS;
+}
+
+//------------------------------------------------------------------------------
+unsigned int TriggerPrimitives::gemConditions(unsigned int trigger_bits)
+{
+    // set corresponding gem bits from glt word, should be a 1 to 1 translation
+    return 
+        ((trigger_bits & enums::b_ROI)    !=0 ? LdfEvent::Gem::ROI   : 0)
+        |((trigger_bits & enums::b_Track) !=0 ? LdfEvent::Gem::TKR   : 0)
+        |((trigger_bits & enums::b_LO_CAL)!=0 ? LdfEvent::Gem::CALLE : 0)
+        |((trigger_bits & enums::b_HI_CAL)!=0 ? LdfEvent::Gem::CALHE : 0)
+        |((trigger_bits & enums::b_ACDH)  !=0 ? LdfEvent::Gem::CNO   : 0) ;
+}
+
+//------------------------------------------------------------------------------
+unsigned int TriggerPrimitives::tracker(const TriRowBitsTds::TkrLayerBits* layerBits, MsgStream& log, unsigned short& tkrVector)const
+{
+    // purpose and method: determine if there is tracker trigger, any 3-in-a-row, 
+    //and fill out the TDS class TriRowBits, with the complete 3-in-a-row information
+
+    // Set default return value
+    tkrVector = 0;
+
+    // the layer bits are shared with TriRowBitsAlg: made from the TkrDigi collection by the first to need them
+    if( layerBits == 0 )
+    {
+        log << MSG::DEBUG << "No tkr digis found" << endreq;
+        return 0;
+    }
+
+    // Are we modifying the tower/bilayer hit pattern?
+    if (m_towersToTurnOn && m_bilayersToTurnOn)
+    {
+        // now look for a three in a row in x-y coincidence, all towers in one pass
+        for(unsigned int idx = 0; idx < NUM_TWRS; idx++)
+        {
+            unsigned int xbits = layerBits->getLayerBits(idx, 0);
+            unsigned int ybits = layerBits->getLayerBits(idx, 1);
+
+            // Is the tower mast bit set for this tower?
+            if (m_towersToTurnOn & 1<<idx)
+            {
+                // Turn on the bits for the bilayers in our "on" mask
+                xbits |= m_bilayersToTurnOn;
+                ybits |= m_bilayersToTurnOn;
+            }
+            tkrVector |= (TriRowBitsTds::TkrLayerBits::three_in_a_row(xbits & ybits)!=0) << idx;
+        }
+    }
+    else
+    {
+        tkrVector = layerBits->getTkrVector();
+    }
+    bool tkr_trig_flag = tkrVector!=0;
+
+    //returns the digi base word, for consistency with the cal and acd.
+    if(tkr_trig_flag) return enums::b_Track;
+    else return 0;
+}
+
+//------------------------------------------------------------------------------
+unsigned int TriggerPrimitives::anticoincidence(const AcdTileTable& acdTiles,
+                                                const Event::AcdDigiCol* tiles, MsgStream& log, unsigned short& cnoVector,
+                                                TileListBits& vetoTiles, unsigned short& roiTowers)const
+{
+    // purpose and method: calculate ACD trigger bits from the list of hit tiles
+
+    // purpose: set ACD trigger bits
+    unsigned int ret=0;
+    cnoVector=0;
+
+    if( tiles == 0 ) {
+        log << MSG::DEBUG << "No acd digis found" << endreq;
+        return ret;
+    }
+    log << MSG::DEBUG << tiles->size() << " tiles found with hits" << endreq;
+
+    for( Event::AcdDigiCol::const_iterator it = tiles->begin(); it !=tiles->end(); ++it){
+        // check if hitMapBit is set (veto) which will correspond to 0.3 MIP.
+        // 20060109 Agreed at Analysis Meeting that onboard threshold is 0.3 MIP
+        const Event::AcdDigi& digi = **it;
+
+        // If the digi is purely overlay, then skip it for the trigger
+        if (digi.getStatus() == (unsigned int)Event::AcdDigi::DIGI_OVERLAY) continue;
+        
+        // Digi id
+        unsigned int id=digi.getId().id();
+        if (id==899)id=1000; // NA tiles are 899 sometimes 
+
+        AcdTileTable::Tile scratch;
+        const AcdTileTable::Tile& tile = acdTiles.tile(id, scratch);
+
+        // veto tile list
+        if ( (digi.getHitMapBit(Event::AcdDigi::A) || digi.getHitMapBit(Event::AcdDigi::B))  ){
+            if (tile.gemValid) vetoTiles.set(tile.gemIndex);
+            else log << MSG::ERROR << "Bad tile gem index: " << tile.gemIndex << endreq;
+            roiTowers |= tile.roiMask;
+            //ret |= enums::b_ACDL; 
+        }
+
+        // now trigger high if either PMT is above threshold
+        bool cnoA = digi.getCno(Event::AcdDigi::A), cnoB = digi.getCno(Event::AcdDigi::B);
+        if ( cnoA || cnoB ){
+            ret |= enums::b_ACDH;
+            // cno vector
+            if (cnoA) cnoVector|=tile.garcBitA;
+            if (cnoB) cnoVector|=tile.garcBitB;
+        }
+    } 
+    return ret;
+}
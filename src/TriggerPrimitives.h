@@ -0,0 +1,97 @@
+/** @file TriggerPrimitives.h
+  *  @brief Declaration of the class TriggerPrimitives
+  *
+  *  $Header:  $
+*/
+
+#ifndef Trigger_TriggerPrimitives_h
+#define Trigger_TriggerPrimitives_h
+
+#include "TileListBits.h"
+#include "AcdTileTable.h"
+
+#include "GaudiKernel/StatusCode.h"
+
+#include "Event/Digi/AcdDigi.h"
+
+class MsgStream;
+class ICalTrigTool;
+namespace Event { class TriggerInfo; }
+namespace TriRowBitsTds { class TkrLayerBits; }
+
+namespace Trigger {
+
+/** @class TriggerPrimitives
+    @brief computes the trigger primitives of an event from the digis
+
+    Used by TriggerInfoAlg, which puts them in the TDS as an Event::TriggerInfo, and by
+    TriggerAlg when it computes them itself (computePrimitives), to use them directly.
+    The tracker, ACD and ROI primitives are cheap; the calorimeter ones, from the CalTrigTool,
+    are computed separately, so that they can be skipped.
+
+    Nothing is changed after initialize: the configuration dependent ACD tile table is passed
+    with each event, and the values are the caller's, so events can be computed concurrently.
+*/
+class TriggerPrimitives {
+public:
+    /// the primitives of an event
+    struct Values {
+        unsigned int   triggerBits;   ///< enums::TriggerBits
+        unsigned short tkrVector;
+        unsigned short roiVector;
+        unsigned short calLoVector;
+        unsigned short calHiVector;
+        unsigned short cnoVector;
+        unsigned short deltaEventTime;       ///< 0xffff: not known here
+        unsigned short deltaWindowOpenTime;  ///< 0xffff: not known here
+        TileListBits   vetoTiles;
+
+        Values(){ clear(); }
+        void clear();
+
+        /// a new TriggerInfo with these values
+        Event::TriggerInfo* makeTriggerInfo()const;
+
+        /// set an existing TriggerInfo to these values
+        void fillTriggerInfo(Event::TriggerInfo& triggerInfo)const;
+    };
+
+    TriggerPrimitives();
+
+    /// @param calTrigTool for the calorimeter primitives
+    /// @param towersToTurnOn towers in which the bilayers below are forced on, for trigger studies
+    /// @param bilayersToTurnOn bilayers forced on in those towers
+    void initialize(ICalTrigTool* calTrigTool, unsigned int towersToTurnOn, unsigned int bilayersToTurnOn);
+
+    /// clear the values, and set the tracker, ACD and ROI primitives
+    /// @param acdTiles tiles and ROI of the trigger configuration of the event
+    /// @param layerBits tracker layers of the event, 0 if no tracker digis
+    /// @param acdDigis ACD digis of the event, 0 if none
+    void compute(const AcdTileTable& acdTiles,
+                 const TriRowBitsTds::TkrLayerBits* layerBits, const Event::AcdDigiCol* acdDigis,
+                 MsgStream& log, Values& values)const;
+
+    /// set the calorimeter primitives
+    StatusCode computeCalorimeter(Values& values)const;
+
+    /// GEM condition summary bits corresponding to trigger bits
+    static unsigned int gemConditions(unsigned int trigger_bits);
+
+private:
+    //! determine tracker trigger bits
+    unsigned int tracker(const TriRowBitsTds::TkrLayerBits* layerBits, MsgStream& log, unsigned short& tkrVector)const;
+
+    //! calculate ACD trigger bits
+    /// @param vetoTiles destination for the veto tile list
+    /// @param roiTowers destination for the OR of the ROI tower masks of the veto tiles
+    unsigned int anticoincidence(const AcdTileTable& acdTiles,
+                                 const Event::AcdDigiCol* tiles, MsgStream& log, unsigned short& cnoVector,
+                                 TileListBits& vetoTiles, unsigned short& roiTowers)const;
+
+    ICalTrigTool*         m_calTrigTool;
+    unsigned int          m_towersToTurnOn;
+    unsigned int          m_bilayersToTurnOn;
+};
+
+}
+#endif
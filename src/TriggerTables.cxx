@@ -7,58 +7,180 @@
 
 #include "TriggerTables.h"
 
+#include "facilities/Util.h"
+
 #include <stdexcept>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
 
 using namespace Trigger;
 
 
+namespace {
+    // The "default" table is parsed and expanded into its lookup table by the compiler.
+    // A pattern character other than 0/1/N/Y/x/X has no PatternBit, a pattern of the
+    // wrong length has no matching Pattern, and a gltword matched by no engine makes
+    // the array size in LutEntry negative: all are compilation errors.
+
+    template<char c> struct PatternBit; // only the specializations below are defined
+    template<> struct PatternBit<'0'>{ enum { care=1, value=0 }; };
+    template<> struct PatternBit<'N'>{ enum { care=1, value=0 }; };
+    template<> struct PatternBit<'1'>{ enum { care=1, value=1 }; };
+    template<> struct PatternBit<'Y'>{ enum { care=1, value=1 }; };
+    template<> struct PatternBit<'x'>{ enum { care=0, value=0 }; };
+    template<> struct PatternBit<'X'>{ enum { care=0, value=0 }; };
+
+    /// condition with the most significant bit (Ext) first, as in the Engine strings
+    template<char b7, char b6, char b5, char b4, char b3, char b2, char b1, char b0>
+    struct Pattern {
+        enum {
+            mask = PatternBit<b7>::care<<7  | PatternBit<b6>::care<<6  | PatternBit<b5>::care<<5
+                 | PatternBit<b4>::care<<4  | PatternBit<b3>::care<<3  | PatternBit<b2>::care<<2
+                 | PatternBit<b1>::care<<1  | PatternBit<b0>::care,
+            value= PatternBit<b7>::value<<7 | PatternBit<b6>::value<<6 | PatternBit<b5>::value<<5
+                 | PatternBit<b4>::value<<4 | PatternBit<b3>::value<<3 | PatternBit<b2>::value<<2
+                 | PatternBit<b1>::value<<1 | PatternBit<b0>::value
+        };
+    };
+
+    template<int n> struct DefaultEngine; // engine n of the default table, with its prescale
+#define DEFAULT_ENGINE(n, b7,b6,b5,b4,b3,b2,b1,b0, ps) \
+    template<> struct DefaultEngine<n> : Pattern<b7,b6,b5,b4,b3,b2,b1,b0> { enum { prescale=ps }; }
+
+    DEFAULT_ENGINE( 0, '1','x','x','x','x','x','x','x',   0);
+    DEFAULT_ENGINE( 1, '0','x','x','x','x','x','0','1',   0);
+    DEFAULT_ENGINE( 2, '0','1','x','x','x','x','x','x',   0);
+    DEFAULT_ENGINE( 3, '0','0','1','x','x','x','x','x',   0);
+
+    // CNO guys
+    DEFAULT_ENGINE( 4, '0','0','0','1','x','1','1','1',   0); // accept CNO only with CALHI+CALLO+ROI
+    DEFAULT_ENGINE( 5, '0','0','0','1','x','x','x','x', 249);
+
+    // gamma patterns
+    DEFAULT_ENGINE( 6, '0','0','0','0','1','x','x','x',   0); // ACDH+ anything
+    DEFAULT_ENGINE( 7, '0','0','0','0','0','x','1','0',   0); // TKR, not ROI possible CALLO
+    DEFAULT_ENGINE( 8, '0','0','0','0','0','1','0','0',   0); // veto CALLO only
+    DEFAULT_ENGINE( 9, '0','0','0','0','0','1','1','1',   0);
+
+    // usually vetoed
+    DEFAULT_ENGINE(10, '0','0','0','0','0','0','1','1',  49); // veto if TRK+ROI
+    // cannot happen
+    DEFAULT_ENGINE(11, '0','0','0','0','0','0','0','0',  -1);
+#undef DEFAULT_ENGINE
+    enum { defaultEngines = 12 };
+
+    /// first engine of the default table that matches word, -1 if none
+    template<int word, int n=0> struct DefaultMatch {
+        enum { engine = (word & DefaultEngine<n>::mask) == DefaultEngine<n>::value
+                        ? n : DefaultMatch<word, n+1>::engine };
+    };
+    template<int word> struct DefaultMatch<word, defaultEngines> { enum { engine = -1 }; };
+
+    template<int word> struct LutEntry {
+        enum { engine = DefaultMatch<word>::engine };
+        typedef char gltword_not_covered_by_default_table[engine>=0 ? 1 : -1];
+    };
+
+#define LUT1(t)  LutEntry<(t)>::engine
+#define LUT4(t)  LUT1(t),     LUT1((t)+1),   LUT1((t)+2),   LUT1((t)+3)
+#define LUT16(t) LUT4(t),     LUT4((t)+4),   LUT4((t)+8),   LUT4((t)+12)
+#define LUT64(t) LUT16(t),    LUT16((t)+16), LUT16((t)+32), LUT16((t)+48)
+    /// engine index for each gltword: constant data, no run-time initialization
+    const unsigned char s_defaultTable[TriggerTables::tableSize] = { LUT64(0), LUT64(64), LUT64(128), LUT64(192) };
+#undef LUT64
+#undef LUT16
+#undef LUT4
+#undef LUT1
+
+    struct EngineSpec { unsigned int mask, value; int prescale; };
+#define SPEC(n) { DefaultEngine<n>::mask, DefaultEngine<n>::value, DefaultEngine<n>::prescale }
+    const EngineSpec s_defaultEngines[defaultEngines] = {
+        SPEC(0), SPEC(1), SPEC(2), SPEC(3), SPEC(4),  SPEC(5),
+        SPEC(6), SPEC(7), SPEC(8), SPEC(9), SPEC(10), SPEC(11)
+    };
+#undef SPEC
+}
+
 TriggerTables::TriggerTables(std::string type, const std::vector<int>& prescale)
+: m_table(s_defaultTable)
 {
-// make a default table for now
     if( type!="default" ){
-        throw std::invalid_argument("TriggerTables only accepts \"default\" configuration");
+        // anything else is the name of a table file
+        read(type, prescale);
+        return;
     }
-    static int psdata[] = {0,0,0,0, 0, 249, 0,0,0 ,0, 49,-1};
-    std::vector<int>defaultps(std::vector<int>(psdata, psdata+12));
-    std::vector<int>::const_iterator ps = defaultps.begin();
-    if( !prescale.empty() ){
-        ps = prescale.begin();
+
+    // the engines are flat (mask, value) pairs: one contiguous block for the whole table
+    reserve(defaultEngines);
+    for( int n=0; n<defaultEngines; ++n){
+        const EngineSpec& spec = s_defaultEngines[n];
+        int ps = prescale.empty()? spec.prescale : prescale.at(n);
+        push_back(Engine(spec.mask, spec.value, n, ps));
     }
+}
 
-    int n(0);
-    push_back(Engine("1 x x x x x x x", n++, *ps++)); //0
-    push_back(Engine("0 x x x x x 0 1", n++, *ps++)); //1
-    push_back(Engine("0 1 x x x x x x", n++, *ps++)); //2
-    push_back(Engine("0 0 1 x x x x x", n++, *ps++)); //3
+void TriggerTables::read(std::string filename, const std::vector<int>& prescale)
+{
+    facilities::Util::expandEnvVar(&filename);
+    std::ifstream in(filename.c_str());
+    if( !in ){
+        throw std::invalid_argument("TriggerTables: could not open trigger table file \""+filename+"\"");
+    }
 
-    // CNO guys
-    push_back(Engine("0 0 0 1 x 1 1 1", n++, *ps++)); //4 accept CNO only with CALHI+CALLO+ROI
-    push_back(Engine("0 0 0 1 x x x x", n++, *ps++)); //5
+    std::string line;
+    for( int lineno=1; std::getline(in, line); ++lineno){
+        std::string::size_type comment = line.find('#');
+        if( comment!=std::string::npos) line.erase(comment);
+        if( line.find_first_not_of(" \t\r")==std::string::npos ) continue;
 
-    // gamma patterns
-    push_back(Engine("0 0 0 0 1 x x x", n++, *ps++)); //6  ACDH+ anything
-    push_back(Engine("0 0 0 0 0 x 1 0", n++, *ps++)); //7  TKR, not ROI possible CALLO
-    push_back(Engine("0 0 0 0 0 1 0 0", n++, *ps++)); //8  veto CALLO only
-    push_back(Engine("0 0 0 0 0 1 1 1", n++, *ps++)); //9
+        std::stringstream where; where << filename << ", line " << lineno;
 
-    // usually vetoed
-    push_back(Engine("0 0 0 0 0 0 1 1", n++, *ps++)); //10 veto if TRK+ROI
-    // cannot happen
-    push_back(Engine("0 0 0 0 0 0 0 0", n++, *ps++)); //11
+        // the condition is the first 8 non-blank characters, most significant bit first
+        std::string condition;
+        std::string::size_type i(0);
+        for( ; i<line.size() && condition.size()<conditionBits; ++i){
+            if( line[i]!=' ' && line[i]!='\t' ) condition += line[i];
+        }
+        if( condition.size()<conditionBits ){
+            throw std::invalid_argument("TriggerTables: condition \""+condition+"\" too short at "+where.str());
+        }
+        int n = size(), ps(0), marker(n);
+        std::istringstream values(line.substr(i));
+        if( !(values >> ps) ){
+            throw std::invalid_argument("TriggerTables: missing prescale at "+where.str());
+        }
+        if( !(values >> marker) ) marker = n; // default marker is the engine number
+        if( !prescale.empty() ) ps = prescale.at(n);
+
+        try {
+            push_back(Engine(condition, marker, ps));
+        }catch(const std::invalid_argument& ){
+            throw std::invalid_argument("TriggerTables: bad condition \""+condition+"\" at "+where.str());
+        }
+    }
+    if( empty() || size()>256 ){
+        throw std::invalid_argument("TriggerTables: wrong number of engines in "+filename);
+    }
 
-    // cache table of Engine for each bit pattern
-    m_table.resize(256);
-    for(int t=0; t<256; ++t){
+    // fill the lookup table: every condition summary must select an engine
+    m_ownTable.resize(tableSize);
+    for( int t=0; t<tableSize; ++t){
         int n = engineNumber(t);
-        const Engine& e(at(n));
-        m_table[t]=&e;
+        if( n<0 ){
+            std::stringstream err;
+            err << "TriggerTables: no engine for condition summary " << t << " in " << filename;
+            throw std::invalid_argument(err.str());
+        }
+        m_ownTable[t] = static_cast<unsigned char>(n);
     }
+    m_table = &m_ownTable[0];
 }
 
 int TriggerTables::engineNumber(int gltword)const
 {
     for(const_iterator it = begin(); it!=end(); ++it){
-        if( it->match(gltword&255) ) return it-begin(); 
+        if( it->match(gltword&conditionMask) ) return it-begin(); 
     }
     return -1; // this should not  happen: will cause assert failure
 }
@@ -66,10 +188,56 @@ int TriggerTables::engineNumber(int gltword)const
 int TriggerTables::operator()(int gltword)const
 {
     // get the cached engine object, check to see if enabled
-    const Engine& e = *m_table[gltword&255];
+    const Engine& e = (*this)[m_table[gltword&conditionMask]];
     return e.check();
 }
 
+int TriggerTables::operator()(int gltword, unsigned long long ordinal)const
+{
+    return (*this)[m_table[gltword&conditionMask]].check(ordinal);
+}
+
+void TriggerTables::seek(const std::vector<unsigned long long>& ordinals)
+{
+    for( unsigned int n=0; n<ordinals.size() && n<size(); ++n){
+        (*this)[n].seek(ordinals[n]);
+    }
+}
+
+void TriggerTables::operator()(const unsigned int* gltwords, size_t count, int* markers, unsigned char* engines)const
+{
+    // two passes per block: the table lookups are independent of each other (and
+    // vectorize), while the prescale counters must advance in event order
+    static const size_t blocksize(256);
+    unsigned char block[blocksize];
+    const Engine* engine = &front();
+
+    for( size_t first=0; first<count; first+=blocksize){
+        size_t n = std::min(blocksize, count-first);
+        const unsigned int* word = gltwords+first;
+        unsigned char* index = engines!=0 ? engines+first : block;
+
+        for( size_t i=0; i<n; ++i){
+            index[i] = m_table[word[i]&conditionMask];
+        }
+        int* marker = markers+first;
+        for( size_t i=0; i<n; ++i){
+            marker[i] = engine[index[i]].check();
+        }
+    }
+}
+
+bool TriggerTables::canPass(int gltword, int unknownMask)const
+{
+    unknownMask &= conditionMask;
+    int known = gltword & conditionMask & ~unknownMask;
+    for( int sub=unknownMask; ; sub=(sub-1)&unknownMask){ // every setting of the unknown bits
+        const Engine& e = (*this)[m_table[known|sub]];
+        if( e.enabled() && e.marker()>0 ) return true;
+        if( sub==0 ) break;
+    }
+    return false;
+}
 
 void TriggerTables::print(std::ostream& out )const
 {
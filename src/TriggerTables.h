@@ -10,6 +10,8 @@
 #include "Engine.h"
 #include <vector>
 #include <iostream>
+#include <string>
+#include <cstddef>
 
 namespace Trigger {
 
@@ -18,27 +20,68 @@ namespace Trigger {
 
     @author T. Burnett <tburnett@u.washington.edu>
 
-    This is a list of engines
+    This is a list of engines, stored contiguously: each Engine is a compiled
+    (mask, value) condition with no heap storage of its own.
+    The "default" table and its lookup table are generated at compile time (see TriggerTables.cxx),
+    so that a malformed pattern or an uncovered gltword does not compile. Other tables are
+    read from a file, and compiled into the same lookup table at construction.
 */
 
 class TriggerTables : public std::vector<Engine> {
 public:
+    /// the table covers the full GEM condition summary:
+    /// Ext, solicited, periodic, CNO, CALHI, CALLO, TKR, ROI
+    enum { conditionBits = 8, tableSize = 1<<conditionBits, conditionMask = tableSize-1 };
 
     /// ctor -- expect to create the engines
-    /// @param configuration specify a trigger table 
+    /// @param configuration specify a trigger table: "default", or the name of a table file
     /// @param prescale vector of prescale factors: if empty, use default in table
+    /// @throw std::invalid_argument if the file cannot be read, or leaves a condition summary without engine
     TriggerTables(std::string configuration, const std::vector<int>& prescale);
 
-    /// for a gltword, return associated engine, or -1 if disabled
+    /// for a gltword (GEM condition summary), return associated engine, or -1 if disabled
     int operator()(int gltword)const;
 
+    /// for a gltword, return associated engine if the event with the given ordinal passes
+    /// the prescale, or -1. Does not change the prescale state.
+    int operator()(int gltword, unsigned long long ordinal)const;
+
+    /// set the ordinal of the next event for each engine, as if that many had been seen.
+    void seek(const std::vector<unsigned long long>& ordinals);
+
+    /// classify a block of gltwords, as would count successive calls of the above
+    /// @param gltwords input words
+    /// @param count number of words
+    /// @param markers output: marker for each word, or -1 if disabled or prescaled
+    /// @param engines optional output: index of the engine selected for each word
+    void operator()(const unsigned int* gltwords, size_t count, int* markers, unsigned char* engines=0)const;
+
+
+    /// true if some gltword that differs from this one only in the bits of unknownMask
+    /// selects an engine that can pass: enabled, with a positive marker
+    bool canPass(int gltword, int unknownMask)const;
 
     /// make a table of the current trigger table
     void print(std::ostream& out = std::cout)const;
 
 private:
+    /** read a table file, one engine per line in order of precedence:
+        @verbatim
+        # Ext solic period CNO CALHI CALLO TRK ROI  prescale [marker]
+          0   0     0      1   x     1     1   1     0
+        @endverbatim
+        '#' starts a comment; the marker defaults to the engine number.
+    */
+    void read(std::string filename, const std::vector<int>& prescale);
+
     int engineNumber(int gltword)const;
-    std::vector<const Engine*> m_table; ///< table of engine  for a bit pattern
+
+    // not copyable: m_table may point into m_ownTable
+    TriggerTables(const TriggerTables&);
+    TriggerTables& operator=(const TriggerTables&);
+
+    const unsigned char* m_table; ///< table of engine index for a bit pattern
+    std::vector<unsigned char> m_ownTable; ///< storage for m_table when not the default table
 };
 }
 
@@ -16,17 +16,61 @@ sets a flag to abort processing of subsequent algorithms in the same sequence.
 @param throttle if set, veto when throttle bit is on
 @param vetomask [1+2+4]  if thottle it set, veto if trigger masked with these ...
 @param vetobits [1+2]    equals these bits
-@param engine [""]   specify data source for engine data. "default" and "TrgConfigSvc are other options
+@param engine [""]   specify data source for engine data. "default" and "TrgConfigSvc are other options.
+Any other value is the name of a trigger table file (environment variables are expanded), with one
+engine per line: the 8 condition bits (Ext solic period CNO CALHI CALLO TRK ROI, each 0, 1 or x),
+the prescale, and optionally the marker. See src/test/engine/default_table.txt for the "default" table.
 @param prescales []  allow to override the prescales. Should be alist of 12 integers
 @param applyPrescales [false] if using TrgConfigSvc, do we want to prescale events?
-@param useGltWordForData [false]   Even if a GEM word exists use the Glt word
+@param useGltWordForData [false]   Even if a GEM word exists use the Glt word, to select the engine of data events, with
+the trigger tables or the ConfigSvc
 @param applyWindowMask [false] Do we want to filter events using the window open mask? Needs to be true for proper GEM simulation
 @param applyDeadtime [false] Filter events based on simulated GEM deadtime supplied by LivetimeSvc
+@param prescaleSeek [] starting count of events for each engine, to continue the prescale sequence of a previous job.
+    Prescale decisions depend only on these counts, so a job over the events that follow those of another makes the
+    same decisions as one job over both, if it starts from the counts where the other ended (see also StateInput, which
+    also holds counts beyond the range of this property). The event number cannot stand for the counts, since an
+    engine only sees some of the events. Negative values are rejected
+@param summaryFile [""] if set, file to write the counts of each trigger bit pattern to at finalize, one
+    "stage,value,count" line per pattern seen, for the stages all, window, prescaled and triggered
+@param summaryReference [""] if set, summaryFile written by another job: finalize fails unless the counts of the
+    triggered stage are the same, e.g. to check that an option does not change which events trigger
+@param computePrimitives [false] compute the trigger primitives from the digis here, as TriggerInfoAlg does,
+    so that TriggerInfoAlg is not needed. The TriggerInfo is then registered only for events that pass
+@param registerTriggerInfo [false] with computePrimitives, register the TriggerInfo for every event
+@param TowersToTurnOn ["0x000"] with computePrimitives, as for TriggerInfoAlg
+@param BilayersToTurnOn ["0x000"] with computePrimitives, as for TriggerInfoAlg
+@param StateInput [""] if set, state file written by StateOutput of a previous job, to continue its prescale
+    counters (after prescaleSeek), last trigger and window times and GEM scalers. Initialize fails if a value
+    is missing. With ConfigSvc the counters are reset if the first event has another MOOT key than the last one
+    of that job. Only slices chained this way, each started after the previous one ended, reproduce a single job:
+    a slice started without StateInput begins from zero, and nothing excludes the events of a warm-up overlap
+    from the counters and scalers
+@param StateOutput [""] if set, file to write that state to at finalize, as "key value" lines with keys that start
+    with the name of the algorithm: the lines of other components already in the file are kept, so LivetimeSvc can
+    write to the same file
 
 
 
 The trigger word, defined below, is copied to the event header.
 
+\section s2 TriggerInfoAlg properties
+TriggerInfoAlg computes the trigger primitives from the digis, and puts them in the TriggerInfo.
+Its engine and prescale properties should match those of TriggerAlg.
+
+@param engine ["ConfigSvc"]  engine data, as for TriggerAlg
+@param prescale []  prescale overrides, as for TriggerAlg
+@param TowersToTurnOn ["0x000"]  towers whose bilayers below are turned on
+@param BilayersToTurnOn ["0x000"]  bilayers to turn on in those towers
+@param lazyPrimitives [false] compute the calorimeter primitives, the expensive ones, only if
+    some value of them selects an engine that can pass, given the tracker, ACD and ROI primitives.
+    Otherwise they are left zero, and a Trigger::PrimitiveStatus in the TDS records that they were
+    not computed. Events with a GEM are always computed in full. TriggerAlg computes the skipped
+    primitives itself unless its own window mask and engines reject the event whatever they are, so
+    the result does not depend on this option; it only saves time when the engines of the two agree
+    (the same engine and prescale properties, and TriggerAlg.applyPrescales with ConfigSvc).
+    See src/test/lazyPrimitivesOptions.txt.
+
 
     \section s3 New Triggerword bit definitions: this is copied from enums/TriggerBits.h  
 
@@ -50,6 +94,19 @@ This new version has the GEM bits coped to the upper 8 bits of the trigger word.
 @param clockrate [20e6]    Number of GEM clock ticks in one second.
 @param TriggerRate  [2000.]     effective total trigger rate.
 @param InterleaveMode [true]    Apply efficiency correction for interleave mode.
+@param RandomStream [-1]    For interleave mode, draw from the RanecuEngine stream with this seed table index,
+owned by the service, rather than from the global engine. Independent jobs can use different streams.
+The index must be less than 215, the size of the table: larger values are rejected, since the engine would wrap them around to
+the stream of another index.
+@param AnalyticMode [false]    For interleave mode, accumulate the expected dead time of the invisible triggers
+(with its variance, reported at the end) and reject the expected fraction of events deterministically, without random numbers:
+an event is rejected if a hash of its GEM clock time, taken as a uniform, is above the efficiency, whatever the events before it.
+@param StateInput [""] if set, state file written by StateOutput of a previous job, to continue its deadtime and livetime,
+and the RandomStream if set, so that the jobs draw the numbers of a single one. Initialize fails if a value is missing.
+The global engine is not part of the state: without RandomStream, interleave mode is only reproducible with AnalyticMode.
+As for TriggerAlg, only a chain of slices reproduces a single job; a slice without StateInput starts from zero.
+@param StateOutput [""] if set, file to write the state to at finalize, as "key value" lines with keys that start with
+the name of the service, as for TriggerAlg
 
 \section s5 ConfigSvc properties
 
@@ -1,15 +1,22 @@
 #include "../../TriggerTables.h"
+#include "../../EnginePrescaleCounter.h"
+#include "../../ConfigEngineTable.h"
+#include "../../TriggerBitHistogram.h"
+#include "../../StateFile.h"
 
 #include <iomanip>
+#include <cassert>
+#include <cstdio>
+#include <sstream>
 
 int main(){
 
     using namespace Trigger;
-    TriggerTables tt;
+    TriggerTables tt("default", std::vector<int>());
 
     tt.print();
     
-    int i = tt[7].match(6); // should match
+    assert( tt[7].match(6) ); // should match
     std::cout << "gltword  marker" << std::endl;
 
 
@@ -19,5 +26,140 @@ int main(){
             << std::right << std::setw(5) << tt(k) << std::endl;
     }
 
+    // the block interface must agree with event-by-event calls, including prescales
+    TriggerTables single("default", std::vector<int>()), batch("default", std::vector<int>());
+    std::vector<unsigned int> words(1000);
+    for (unsigned int k=0; k<words.size(); ++k) words[k] = (k*37)&255;
+    std::vector<int> markers(words.size());
+    std::vector<unsigned char> engines(words.size());
+    batch(&words[0], words.size(), &markers[0], &engines[0]);
+    for (unsigned int k=0; k<words.size(); ++k){
+        assert( markers[k] == single(words[k]) );
+        assert( batch[engines[k]].match(words[k]) );
+    }
+
+    // canPass: engine 0 (Ext) has marker 0, engine 11 (no condition) is disabled,
+    // but CALLO alone selects engine 8
+    assert( !tt.canPass(128, 4|8) );
+    assert( !tt.canPass(0, 0) );
+    assert(  tt.canPass(0, 4|8) );
+    assert(  tt.canPass(2, 0) );
+
+    // a table file with the same engines must give the same lookup table
+    TriggerTables fromfile("$(TRIGGERROOT)/src/test/engine/default_table.txt", std::vector<int>());
+    fromfile.print();
+    assert( fromfile.size()==tt.size() );
+    for (int k=0; k<TriggerTables::tableSize; ++k){
+        unsigned int word(k);
+        int m1, m2;
+        unsigned char e1, e2;
+        tt(&word, 1, &m1, &e1);
+        fromfile(&word, 1, &m2, &e2);
+        assert( e1==e2 );
+    }
+
+    // a prescale decision is a function of the engine's ordinal: checking the ordinals counted
+    // here, or seeking to them part way, must give the decisions of the serial calls
+    std::vector<int> prescales(12, 0);
+    prescales[5] = 3; prescales[7] = 4; prescales[10] = 2;
+    TriggerTables serial("default", prescales), bycount("default", prescales), resumed("default", prescales);
+    std::vector<unsigned long long> counts(serial.size(), 0);
+    for (unsigned int k=0; k<words.size(); ++k){
+        unsigned int word = words[k];
+        int expected = serial(word);
+        unsigned char engine;
+        int marker;
+        bycount(&word, 1, &marker, &engine);
+        assert( bycount(word, counts[engine]++) == expected );
+        if( k==words.size()/2 ) resumed.seek(counts);
+        if( k>=words.size()/2 ) assert( resumed(word) == expected );
+    }
+
+    // ConfigSvc counters: four engines, the last one disabled; the block interface
+    // must agree with event-by-event calls
+    ConfigEngineTable config;
+    for (unsigned int k=0; k<ConfigEngineTable::tableSize; ++k){
+        int engine = k&3;
+        ConfigEngineTable::Entry entry = { engine, engine==3 ? -1 : 2*engine, false, false };
+        config.set(k, entry);
+    }
+    assert( config.engines()==4 );
+    std::vector<int> noOverrides;
+    EnginePrescaleCounter counter(noOverrides), blockCounter(noOverrides);
+    counter.configure(config);
+    blockCounter.configure(config);
+    bool passed[1000];
+    blockCounter.decrementAndCheck(&words[0], words.size(), passed);
+    for (unsigned int k=0; k<words.size(); ++k){
+        assert( passed[k] == counter.decrementAndCheck(words[k]) );
+    }
+    for (unsigned int engine=0; engine<4; ++engine){
+        assert( blockCounter.ordinal(engine) == counter.ordinal(engine) );
+    }
+
+    // as for the tables: check() on counted ordinals, and seek() part way, agree with the serial calls
+    EnginePrescaleCounter serialCounter(noOverrides), resumedCounter(noOverrides);
+    serialCounter.configure(config);
+    resumedCounter.configure(config);
+    std::vector<unsigned long long> ordinals(4, 0);
+    for (unsigned int k=0; k<words.size(); ++k){
+        bool expected = serialCounter.decrementAndCheck(words[k]);
+        assert( counter.check(words[k], ordinals[words[k]&3]++) == expected );
+        if( k==words.size()/2 ){
+            for (unsigned int engine=0; engine<4; ++engine) resumedCounter.seek(engine, ordinals[engine]);
+        }
+        if( k>=words.size()/2 ) assert( resumedCounter.decrementAndCheck(words[k]) == expected );
+    }
+    // ordinals beyond 32 bits: engine 2 passes one event in 5
+    resumedCounter.seek(2, (5ULL<<32)+3);
+    assert( !resumedCounter.decrementAndCheck(2) );
+    assert(  resumedCounter.decrementAndCheck(2) );
+    assert(  resumedCounter.check(2, (5ULL<<32)+9) );
+
+    // histograms of two halves of the events, added, are the histogram of all of them
+    TriggerBitHistogram all, first, second;
+    for (unsigned int k=0; k<words.size(); ++k){
+        unsigned int bits = k%3==0 ? words[k]<<1 : words[k]; // some beyond the histogram
+        all.fill(bits);
+        (k<words.size()/2 ? first : second).fill(bits);
+    }
+    first += second;
+    assert( first.total()==all.total() && first.total()==words.size() );
+    assert( first.overflow()==all.overflow() && all.overflow()>0 );
+    for (unsigned int k=0; k<TriggerBitHistogram::size; ++k){
+        assert( first.count(k)==all.count(k) );
+    }
+
+    // a histogram read back from the summary lines of its label is the one written
+    std::stringstream summary;
+    first.write(summary, "window");
+    all.write(summary, "triggered");
+    TriggerBitHistogram readBack;
+    assert( readBack.read(summary, "triggered") && readBack==all && !(readBack==second) );
+
+    // a state file written by two components reads back the values of each, at full precision
+    const char* stateName = "testStateFile.txt";
+    std::remove(stateName);
+    StateFile alg("TriggerAlg."), svc("LivetimeSvc.");
+    alg.set("lastTriggerTick", (5ULL<<32)+3);
+    alg.set("firstTriggerTime", 1.0/3);
+    svc.set("lastTriggerTick", 7ULL);
+    assert( alg.write(stateName) && svc.write(stateName) );
+    alg.set("firstTriggerTime", 2.0/3); // written again: replaces its own lines only
+    assert( alg.write(stateName) );
+
+    StateFile algIn("TriggerAlg."), svcIn("LivetimeSvc.");
+    assert( algIn.read(stateName) && svcIn.read(stateName) );
+    unsigned long long tick(0), svcTick(0), absent(11);
+    double time(0);
+    algIn.require("lastTriggerTick", tick);
+    algIn.require("firstTriggerTime", time);
+    svcIn.require("lastTriggerTick", svcTick);
+    assert( tick==(5ULL<<32)+3 && time==2.0/3 && svcTick==7 );
+    assert( algIn.missing().empty() && svcIn.missing().empty() );
+    svcIn.require("firstTriggerTime", absent);
+    assert( absent==11 && svcIn.missing().size()==1 && svcIn.missing()[0]=="LivetimeSvc.firstTriggerTime" );
+    std::remove(stateName);
+
     return 0;
-}
\ No newline at end of file
+}